@@ -6,11 +6,18 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <stack>
+#include <deque>
 #include <cassert>
 #include <unordered_map>
+#include <unordered_set>
 #include <memory>
+#include <new>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
 
 std::size_t MemFastHash( const void* InData, std::size_t InLength, std::size_t InHash = 0 )
 {
@@ -22,6 +29,106 @@ std::size_t MemFastHash( const void* InData, std::size_t InLength, std::size_t I
 	return InHash;
 }
 
+// Runtime error of script execution
+enum EExecutionError
+{
+	EE_None,
+	EE_MemoryLimit,         // Allocation was refused or exceeded limit
+	EE_IntegerOverflow,     // Integer operation overflowed
+	EE_DivideByZero         // Integer division by zero
+};
+
+// State of script execution on current thread
+struct FExecutionState
+{
+	FExecutionState()
+		: isExecuting( false ), isNoAllocation( false ), error( EE_None ), numHeapAllocations( 0 ), numHeapBytes( 0 ), maxHeapBytes( 0 )
+	{
+	}
+
+	bool            isExecuting;            // Script is executing
+	bool            isNoAllocation;         // Interpreter loop runs in zero-allocation mode
+	EExecutionError error;                  // Runtime error, execution must stop if it isn't EE_None
+	std::size_t     numHeapAllocations;     // Number of heap allocations made by execution
+	std::size_t     numHeapBytes;           // Heap bytes allocated by execution
+	std::size_t     maxHeapBytes;           // Limit of heap bytes, 0 - no limit
+};
+
+thread_local FExecutionState        GExecutionState;
+
+// Heap statistics of execution, heap limit and allocation hook of zero-allocation mode replace global operators new and delete.
+// Build with SCRIPT_HEAP_STATS 0 to keep operators of runtime, then heap of execution isn't counted
+#ifndef SCRIPT_HEAP_STATS
+	#define SCRIPT_HEAP_STATS 1
+#endif // !SCRIPT_HEAP_STATS
+
+#if SCRIPT_HEAP_STATS
+#ifndef NDEBUG
+void AssertNoAllocation( std::size_t InSize )
+{
+	printf( "Error: heap allocation of %i bytes inside interpreter loop\n", ( int ) InSize );
+	assert( false );
+}
+
+// Called on heap allocation in zero-allocation mode
+void ( *GNoAllocationHook )( std::size_t ) = &AssertNoAllocation;
+#else
+void ( *GNoAllocationHook )( std::size_t ) = nullptr;
+#endif // !NDEBUG
+
+// Replaced operators new and delete are never inlined, otherwise GCC sees malloc/free pairs across them and reports mismatched deallocation
+#if defined( __GNUC__ ) || defined( __clang__ )
+	#define SCRIPT_ALLOCATOR_NOINLINE __attribute__( ( noinline ) )
+#else
+	#define SCRIPT_ALLOCATOR_NOINLINE
+#endif // __GNUC__ || __clang__
+
+SCRIPT_ALLOCATOR_NOINLINE void* operator new( std::size_t InSize )
+{
+	if ( GExecutionState.isExecuting )
+	{
+		++GExecutionState.numHeapAllocations;
+		GExecutionState.numHeapBytes += InSize;
+		if ( GExecutionState.maxHeapBytes > 0 && GExecutionState.numHeapBytes > GExecutionState.maxHeapBytes )
+		{
+			GExecutionState.error = EE_MemoryLimit;
+		}
+
+		if ( GExecutionState.isNoAllocation && GNoAllocationHook )
+		{
+			GNoAllocationHook( InSize );
+		}
+	}
+
+	void* ptr = malloc( InSize > 0 ? InSize : 1 );
+	if ( !ptr )
+	{
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+SCRIPT_ALLOCATOR_NOINLINE void operator delete( void* InPtr ) noexcept
+{
+	free( InPtr );
+}
+
+SCRIPT_ALLOCATOR_NOINLINE void operator delete( void* InPtr, std::size_t /*InSize*/ ) noexcept
+{
+	free( InPtr );
+}
+#endif // SCRIPT_HEAP_STATS
+
+// Threaded dispatch of interpreter loop uses labels as values, supported only by GCC and Clang
+#if defined( __GNUC__ ) || defined( __clang__ )
+	#define SCRIPT_THREADED_DISPATCH 1
+#else
+	#define SCRIPT_THREADED_DISPATCH 0
+#endif // __GNUC__ || __clang__
+
+// Use threaded dispatch in interpreter loop, otherwise switch. Can be changed at runtime to compare engines
+bool        GIsThreadedDispatch = SCRIPT_THREADED_DISPATCH;
+
 enum EScriptOperation
 {
 	Op_Nope,
@@ -42,14 +149,370 @@ enum EScriptOperation
 	Op_Substruct,
 	Op_Multiply,
 	Op_Divide,
+	Op_AddAssign,
+	Op_Return,
+
+	// Type specialized operations, emitted by FFunction::SpecializeTypes when types of operands are known
+	Op_AssignInt,
+	Op_AssignDouble,
+	Op_AddInt,
+	Op_SubstructInt,
+	Op_MultiplyInt,
+	Op_DivideInt,
+	Op_AddAssignInt,
+	Op_AddDouble,
+	Op_SubstructDouble,
+	Op_MultiplyDouble,
+	Op_DivideDouble,
+	Op_AddAssignDouble,
+	Op_ConcatString,
+	Op_AppendString,
+	Op_CompareInt,
+	Op_NotCompareInt,
+	Op_MoreInt,
+	Op_MoreThenInt,
+	Op_LessInt,
+	Op_LessThenInt,
+	Op_CompareDouble,
+	Op_NotCompareDouble,
+	Op_MoreDouble,
+	Op_MoreThenDouble,
+	Op_LessDouble,
+	Op_LessThenDouble,
+	Op_CompareString,
+	Op_NotCompareString,
+
+	// Superinstructions, emitted by FFunction::FuseOperations. Typed arithmetic writes result directly to var instead of register,
+	// branch falls through when comparison is true and jumps to target otherwise
+	Op_AddIntTo,
+	Op_SubstructIntTo,
+	Op_MultiplyIntTo,
+	Op_DivideIntTo,
+	Op_AddDoubleTo,
+	Op_SubstructDoubleTo,
+	Op_MultiplyDoubleTo,
+	Op_DivideDoubleTo,
+	Op_ConcatStringTo,
+	Op_CompareBranch,
+	Op_NotCompareBranch,
+	Op_MoreBranch,
+	Op_MoreThenBranch,
+	Op_LessBranch,
+	Op_LessThenBranch,
+	Op_CompareIntBranch,
+	Op_NotCompareIntBranch,
+	Op_MoreIntBranch,
+	Op_MoreThenIntBranch,
+	Op_LessIntBranch,
+	Op_LessThenIntBranch,
+	Op_CompareDoubleBranch,
+	Op_NotCompareDoubleBranch,
+	Op_MoreDoubleBranch,
+	Op_MoreThenDoubleBranch,
+	Op_LessDoubleBranch,
+	Op_LessThenDoubleBranch,
+	Op_CompareStringBranch,
+	Op_NotCompareStringBranch,
+
+	// Script call in tail position, emitted by FFunction::EliminateTailCalls. Callee reuses frame of caller and returns directly to its caller
+	Op_TailCall,
+
+	Op_Num
+};
+
+// Layout of operation in byte code
+enum EOperationFormat
+{
+	OF_None,            // [op]
+	OF_Call,            // [op functionId numArgs (varFlag varId)*numArgs]
+	OF_AllocateVar,     // [op varType varId]
+	OF_Binary,          // [op leftVarId rightVarFlag rightVarId], left is always user var
+	OF_Arithmetic,      // [op resultRegister leftVarId rightVarFlag rightVarId], left is always user var
+	OF_Compare,         // [op leftVarFlag leftVarId rightVarFlag rightVarId]
+	OF_Jump,            // [op target]
+	OF_Ternary,         // [op resultVarId leftVarId rightVarFlag rightVarId], result and left are always user vars
+	OF_Branch           // [op leftVarFlag leftVarId rightVarFlag rightVarId target]
 };
 
+inline EOperationFormat GetOperationFormat( int InOperation )
+{
+	switch ( InOperation )
+	{
+	case Op_Call:
+	case Op_NativeCall:
+	case Op_TailCall:
+		return OF_Call;
+
+	case Op_AllocateVar:
+		return OF_AllocateVar;
+
+	case Op_Assign:
+	case Op_AddAssign:
+	case Op_AssignInt:
+	case Op_AssignDouble:
+	case Op_AddAssignInt:
+	case Op_AddAssignDouble:
+	case Op_AppendString:
+		return OF_Binary;
+
+	case Op_Add:
+	case Op_Substruct:
+	case Op_Multiply:
+	case Op_Divide:
+	case Op_AddInt:
+	case Op_SubstructInt:
+	case Op_MultiplyInt:
+	case Op_DivideInt:
+	case Op_AddDouble:
+	case Op_SubstructDouble:
+	case Op_MultiplyDouble:
+	case Op_DivideDouble:
+	case Op_ConcatString:
+		return OF_Arithmetic;
+
+	case Op_Compare:
+	case Op_NotCompare:
+	case Op_More:
+	case Op_MoreThen:
+	case Op_Less:
+	case Op_LessThen:
+	case Op_CompareInt:
+	case Op_NotCompareInt:
+	case Op_MoreInt:
+	case Op_MoreThenInt:
+	case Op_LessInt:
+	case Op_LessThenInt:
+	case Op_CompareDouble:
+	case Op_NotCompareDouble:
+	case Op_MoreDouble:
+	case Op_MoreThenDouble:
+	case Op_LessDouble:
+	case Op_LessThenDouble:
+	case Op_CompareString:
+	case Op_NotCompareString:
+		return OF_Compare;
+
+	case Op_JumpNotEqual:
+	case Op_JumpEqual:
+	case Op_Jump:
+		return OF_Jump;
+
+	case Op_AddIntTo:
+	case Op_SubstructIntTo:
+	case Op_MultiplyIntTo:
+	case Op_DivideIntTo:
+	case Op_AddDoubleTo:
+	case Op_SubstructDoubleTo:
+	case Op_MultiplyDoubleTo:
+	case Op_DivideDoubleTo:
+	case Op_ConcatStringTo:
+		return OF_Ternary;
+
+	case Op_CompareBranch:
+	case Op_NotCompareBranch:
+	case Op_MoreBranch:
+	case Op_MoreThenBranch:
+	case Op_LessBranch:
+	case Op_LessThenBranch:
+	case Op_CompareIntBranch:
+	case Op_NotCompareIntBranch:
+	case Op_MoreIntBranch:
+	case Op_MoreThenIntBranch:
+	case Op_LessIntBranch:
+	case Op_LessThenIntBranch:
+	case Op_CompareDoubleBranch:
+	case Op_NotCompareDoubleBranch:
+	case Op_MoreDoubleBranch:
+	case Op_MoreThenDoubleBranch:
+	case Op_LessDoubleBranch:
+	case Op_LessThenDoubleBranch:
+	case Op_CompareStringBranch:
+	case Op_NotCompareStringBranch:
+		return OF_Branch;
+
+	default:
+		return OF_None;
+	}
+}
+
+// Name of operation for byte code dump
+inline const char* GetOperationName( int InOperation )
+{
+	// Order must match EScriptOperation
+	static const char* const        operationNames[] =
+	{
+		"Nope",
+		"Call",
+		"NativeCall",
+		"AllocateVar",
+		"Assign",
+		"Compare",
+		"NotCompare",
+		"More",
+		"MoreThen",
+		"Less",
+		"LessThen",
+		"JumpNotEqual",
+		"JumpEqual",
+		"Jump",
+		"Add",
+		"Substruct",
+		"Multiply",
+		"Divide",
+		"AddAssign",
+		"Return",
+		"AssignInt",
+		"AssignDouble",
+		"AddInt",
+		"SubstructInt",
+		"MultiplyInt",
+		"DivideInt",
+		"AddAssignInt",
+		"AddDouble",
+		"SubstructDouble",
+		"MultiplyDouble",
+		"DivideDouble",
+		"AddAssignDouble",
+		"ConcatString",
+		"AppendString",
+		"CompareInt",
+		"NotCompareInt",
+		"MoreInt",
+		"MoreThenInt",
+		"LessInt",
+		"LessThenInt",
+		"CompareDouble",
+		"NotCompareDouble",
+		"MoreDouble",
+		"MoreThenDouble",
+		"LessDouble",
+		"LessThenDouble",
+		"CompareString",
+		"NotCompareString",
+		"AddIntTo",
+		"SubstructIntTo",
+		"MultiplyIntTo",
+		"DivideIntTo",
+		"AddDoubleTo",
+		"SubstructDoubleTo",
+		"MultiplyDoubleTo",
+		"DivideDoubleTo",
+		"ConcatStringTo",
+		"CompareBranch",
+		"NotCompareBranch",
+		"MoreBranch",
+		"MoreThenBranch",
+		"LessBranch",
+		"LessThenBranch",
+		"CompareIntBranch",
+		"NotCompareIntBranch",
+		"MoreIntBranch",
+		"MoreThenIntBranch",
+		"LessIntBranch",
+		"LessThenIntBranch",
+		"CompareDoubleBranch",
+		"NotCompareDoubleBranch",
+		"MoreDoubleBranch",
+		"MoreThenDoubleBranch",
+		"LessDoubleBranch",
+		"LessThenDoubleBranch",
+		"CompareStringBranch",
+		"NotCompareStringBranch",
+		"TailCall"
+	};
+	static_assert( sizeof( operationNames ) / sizeof( operationNames[ 0 ] ) == Op_Num, "Operation names don't match EScriptOperation" );
+
+	return InOperation >= 0 && InOperation < Op_Num ? operationNames[ InOperation ] : "Unknown";
+}
+
+// Size of operation starting at InCode
+inline int GetOperationSize( const int* InCode )
+{
+	switch ( GetOperationFormat( InCode[ 0 ] ) )
+	{
+	case OF_Call:           return 3 + InCode[ 2 ] * 2;
+	case OF_AllocateVar:    return 3;
+	case OF_Binary:         return 4;
+	case OF_Arithmetic:     return 5;
+	case OF_Compare:        return 5;
+	case OF_Jump:           return 2;
+	case OF_Ternary:        return 5;
+	case OF_Branch:         return 6;
+	default:                return 1;
+	}
+}
+
+// Packed byte code executed by interpreter: 1-byte opcode followed by 16-bit operands. Var flags are dropped, they are
+// kept in operand table of function. Operands are read with memcpy, which is a plain load on x86 and ARM, so operands
+// don't need alignment
+typedef uint16_t        FPackedOperand;
+static_assert( Op_Num <= UINT8_MAX, "Opcode doesn't fit in packed byte code" );
+
+inline int ReadPackedOperand( const uint8_t* InCode )
+{
+	FPackedOperand      operand;
+	memcpy( &operand, InCode, sizeof( FPackedOperand ) );
+	return operand;
+}
+
+// Number of operands of operation in packed byte code
+inline int GetNumPackedOperands( int InOperation, int InNumArgs )
+{
+	switch ( GetOperationFormat( InOperation ) )
+	{
+	case OF_Call:           return 2 + InNumArgs;
+	case OF_AllocateVar:
+	case OF_Binary:
+	case OF_Compare:        return 2;
+	case OF_Arithmetic:
+	case OF_Ternary:
+	case OF_Branch:         return 3;
+	case OF_Jump:           return 1;
+	default:                return 0;
+	}
+}
+
+// Append operation to packed byte code, return false if operand doesn't fit in 16 bits
+inline bool EncodeOperation( int InOperation, const std::vector<int>& InOperands, std::vector<uint8_t>& OutCode )
+{
+	OutCode.push_back( ( uint8_t ) InOperation );
+	for ( int operand : InOperands )
+	{
+		if ( operand < 0 || operand > UINT16_MAX )
+		{
+			return false;
+		}
+
+		FPackedOperand      packedOperand = ( FPackedOperand ) operand;
+		uint8_t             bytes[ sizeof( FPackedOperand ) ];
+		memcpy( bytes, &packedOperand, sizeof( FPackedOperand ) );
+		OutCode.insert( OutCode.end(), bytes, bytes + sizeof( FPackedOperand ) );
+	}
+	return true;
+}
+
+// Decode operation at InCode of packed byte code, return its size in bytes
+inline int DecodeOperation( const uint8_t* InCode, int& OutOperation, std::vector<int>& OutOperands )
+{
+	OutOperation = InCode[ 0 ];
+	OutOperands.clear();
+
+	int     numArgs = GetOperationFormat( OutOperation ) == OF_Call ? ReadPackedOperand( InCode + 1 + sizeof( FPackedOperand ) ) : 0;
+	int     numOperands = GetNumPackedOperands( OutOperation, numArgs );
+	for ( int i = 0; i < numOperands; ++i )
+	{
+		OutOperands.push_back( ReadPackedOperand( InCode + 1 + i * sizeof( FPackedOperand ) ) );
+	}
+	return 1 + numOperands * sizeof( FPackedOperand );
+}
+
 enum EScriptVarType
 {
 	SVT_None,
 	SVT_String,
 	SVT_Int,
-	SVT_Bool
+	SVT_Bool,
+	SVT_Double
 };
 
 enum EScriptVarFlag
@@ -60,28 +523,130 @@ enum EScriptVarFlag
 	SVF_Register
 };
 
-enum EScriptRegister
+// Checked 64-bit integer arithmetic, return false on overflow. OutResult is written only on success, so it may alias an operand
+inline bool CheckedAdd( int64_t InA, int64_t InB, int64_t& OutResult )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	int64_t     result;
+	if ( __builtin_add_overflow( InA, InB, &result ) )
+	{
+		return false;
+	}
+
+	OutResult = result;
+	return true;
+#else
+	if ( InB > 0 ? InA > INT64_MAX - InB : InA < INT64_MIN - InB )
+	{
+		return false;
+	}
+
+	OutResult = InA + InB;
+	return true;
+#endif // __GNUC__ || __clang__
+}
+
+inline bool CheckedSubstruct( int64_t InA, int64_t InB, int64_t& OutResult )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	int64_t     result;
+	if ( __builtin_sub_overflow( InA, InB, &result ) )
+	{
+		return false;
+	}
+
+	OutResult = result;
+	return true;
+#else
+	if ( InB > 0 ? InA < INT64_MIN + InB : InA > INT64_MAX + InB )
+	{
+		return false;
+	}
+
+	OutResult = InA - InB;
+	return true;
+#endif // __GNUC__ || __clang__
+}
+
+inline bool CheckedMultiply( int64_t InA, int64_t InB, int64_t& OutResult )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+	int64_t     result;
+	if ( __builtin_mul_overflow( InA, InB, &result ) )
+	{
+		return false;
+	}
+
+	OutResult = result;
+	return true;
+#else
+	if ( InA > 0 ? ( InB > 0 ? InA > INT64_MAX / InB : InB < INT64_MIN / InA )
+		 : ( InB > 0 ? InA < INT64_MIN / InB : InA != 0 && InB < INT64_MAX / InA ) )
+	{
+		return false;
+	}
+
+	OutResult = InA * InB;
+	return true;
+#endif // __GNUC__ || __clang__
+}
+
+// Table of unique strings, interned strings have stable addresses and are compared by pointer
+class FStringTable
 {
-	SR_AX,
-	SR_Num
+public:
+	const std::string* Intern( const std::string& InStr )
+	{
+		return &*strings.insert( InStr ).first;
+	}
+
+	int GetNumStrings() const
+	{
+		return strings.size();
+	}
+
+	std::size_t GetMemoryBytes() const
+	{
+		std::size_t     numBytes = 0;
+		for ( auto it = strings.begin(), itEnd = strings.end(); it != itEnd; ++it )
+		{
+			numBytes += sizeof( std::string ) + it->capacity() + 1;
+		}
+		return numBytes;
+	}
+
+private:
+	std::unordered_set<std::string>     strings;
 };
 
 class FScriptVar
 {
 public:
+	struct FHashFunc
+	{
+		std::size_t operator()( const FScriptVar& InVar ) const
+		{
+			return InVar.GetHash();
+		}
+	};
+
+	struct FEqualFunc
+	{
+		bool operator()( const FScriptVar& InA, const FScriptVar& InB ) const
+		{
+			return InA.varType == InB.varType && InA.Compare( InB );
+		}
+	};
+
 	FScriptVar()
-		: ptr( nullptr )
+		: varType( SVT_None ), internedString( nullptr ), intValue( 0 )
 	{
 	}
 
 	FScriptVar( const FScriptVar& InCopy )
+		: varType( SVT_None ), internedString( nullptr ), intValue( 0 )
 	{
-		switch ( InCopy.varType )
-		{
-		case SVT_String:    SetString( InCopy.GetString() );    break;
-		case SVT_Int:       SetInt( InCopy.GetInt() );          break;
-		case SVT_Bool:       SetBool( InCopy.GetBool() );          break;
-		}
+		Set( InCopy );
 	}
 
 	~FScriptVar()
@@ -91,187 +656,305 @@ public:
 
 	FScriptVar& operator=( const FScriptVar& InCopy )
 	{
-		switch ( InCopy.varType )
-		{
-		case SVT_String:    SetString( InCopy.GetString() );    break;
-		case SVT_Int:       SetInt( InCopy.GetInt() );          break;
-		case SVT_Bool:      SetBool( InCopy.GetBool() );          break;
-		}
+		Set( InCopy );
 		return *this;
 	}
 
-	static std::shared_ptr<FScriptVar> Add( std::shared_ptr<FScriptVar> InLeft, std::shared_ptr<FScriptVar> InRight )
+	static void AddInto( FScriptVar& OutResult, const FScriptVar& InLeft, const FScriptVar& InRight )
 	{
-		std::shared_ptr<FScriptVar>		result = std::make_shared<FScriptVar>();
-
-		if ( InLeft->varType != InRight->varType )
+		if ( InLeft.varType != InRight.varType )
 		{
-			return result;
+			return;
 		}
 
-		switch ( InLeft->varType )
+		switch ( InLeft.varType )
 		{
-		case SVT_String:    result->SetString( InLeft->GetString() + InRight->GetString() ); break;
-		case SVT_Int:       result->SetInt( InLeft->GetInt() + InRight->GetInt() ); break;
-		case SVT_Bool:      result->SetBool( InLeft->GetBool() + InRight->GetBool() ); break;
+		case SVT_String:    ConcatInto( OutResult, InLeft, InRight ); break;
+
+		case SVT_Int:
+		{
+			int64_t     result;
+			if ( !CheckedAdd( InLeft.intValue, InRight.intValue, result ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				return;
+			}
+			OutResult.SetInt( result );
+			break;
+		}
+
+		case SVT_Bool:      OutResult.SetBool( InLeft.boolValue + InRight.boolValue ); break;
+		case SVT_Double:    OutResult.SetDouble( InLeft.doubleValue + InRight.doubleValue ); break;
 		default:
 			assert( false );
-			return result;
+			break;
 		}
+	}
 
-		return result;
+	// OutResult = InLeft + InRight for strings, buffer of result is reused
+	static void ConcatInto( FScriptVar& OutResult, const FScriptVar& InLeft, const FScriptVar& InRight )
+	{
+		assert( InLeft.varType == SVT_String && InRight.varType == SVT_String );
+		if ( &OutResult == &InRight )
+		{
+			if ( !OutResult.IsStringFit( std::string::npos ) )
+			{
+				return;
+			}
+			OutResult.SetString( InLeft.stringValue + InRight.stringValue );
+		}
+		else if ( OutResult.IsStringFit( InLeft.stringValue.size() + InRight.stringValue.size() ) )
+		{
+			OutResult.SetString( InLeft.stringValue );
+			OutResult.stringValue.append( InRight.stringValue );
+		}
 	}
 
-	static std::shared_ptr<FScriptVar> Substruct( std::shared_ptr<FScriptVar> InLeft, std::shared_ptr<FScriptVar> InRight )
+	// Append string in place
+	void Append( const FScriptVar& InRight )
 	{
-		std::shared_ptr<FScriptVar>		result = std::make_shared<FScriptVar>();
+		assert( varType == SVT_String && InRight.varType == SVT_String );
+		if ( !IsStringFit( stringValue.size() + InRight.stringValue.size() ) )
+		{
+			return;
+		}
+
+		stringValue.append( InRight.stringValue );
+		internedString = nullptr;
+	}
 
-		if ( InLeft->varType != InRight->varType )
+	// InOutLeft += InRight, strings are appended in place
+	static void AddAssign( FScriptVar& InOutLeft, const FScriptVar& InRight )
+	{
+		if ( InOutLeft.varType != InRight.varType )
 		{
-			return result;
+			return;
 		}
 
-		switch ( InLeft->varType )
+		switch ( InOutLeft.varType )
 		{
-		case SVT_String:    result->SetString( "Not supported operation" ); break;
-		case SVT_Int:       result->SetInt( InLeft->GetInt() - InRight->GetInt() ); break;
-		case SVT_Bool:      result->SetBool( InLeft->GetBool() - InRight->GetBool() ); break;
+		case SVT_String:    InOutLeft.Append( InRight ); break;
+
+		case SVT_Int:
+			if ( !CheckedAdd( InOutLeft.intValue, InRight.intValue, InOutLeft.intValue ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+			}
+			break;
+
+		case SVT_Bool:      InOutLeft.boolValue = InOutLeft.boolValue + InRight.boolValue; break;
+		case SVT_Double:    InOutLeft.doubleValue += InRight.doubleValue; break;
 		default:
 			assert( false );
-			return result;
+			break;
 		}
-
-		return result;
 	}
 
-	static std::shared_ptr<FScriptVar> Multiply( std::shared_ptr<FScriptVar> InLeft, std::shared_ptr<FScriptVar> InRight )
+	static void SubstructInto( FScriptVar& OutResult, const FScriptVar& InLeft, const FScriptVar& InRight )
 	{
-		std::shared_ptr<FScriptVar>		result = std::make_shared<FScriptVar>();
-
-		if ( InLeft->varType != InRight->varType )
+		if ( InLeft.varType != InRight.varType )
 		{
-			return result;
+			return;
 		}
 
-		switch ( InLeft->varType )
+		switch ( InLeft.varType )
 		{
-		case SVT_String:    result->SetString( "Not supported operation" ); break;
-		case SVT_Int:       result->SetInt( InLeft->GetInt() * InRight->GetInt() ); break;
-		case SVT_Bool:      result->SetBool( InLeft->GetBool() * InRight->GetBool() ); break;
+		case SVT_String:    OutResult.SetString( "Not supported operation" ); break;
+		case SVT_Int:
+		{
+			int64_t     result;
+			if ( !CheckedSubstruct( InLeft.intValue, InRight.intValue, result ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				return;
+			}
+			OutResult.SetInt( result );
+			break;
+		}
+
+		case SVT_Bool:      OutResult.SetBool( InLeft.boolValue - InRight.boolValue ); break;
+		case SVT_Double:    OutResult.SetDouble( InLeft.doubleValue - InRight.doubleValue ); break;
 		default:
 			assert( false );
-			return result;
+			break;
 		}
-
-		return result;
 	}
 
-	static std::shared_ptr<FScriptVar> Divide( std::shared_ptr<FScriptVar> InLeft, std::shared_ptr<FScriptVar> InRight )
+	static void MultiplyInto( FScriptVar& OutResult, const FScriptVar& InLeft, const FScriptVar& InRight )
 	{
-		std::shared_ptr<FScriptVar>		result = std::make_shared<FScriptVar>();
+		if ( InLeft.varType != InRight.varType )
+		{
+			return;
+		}
+
+		switch ( InLeft.varType )
+		{
+		case SVT_String:    OutResult.SetString( "Not supported operation" ); break;
+		case SVT_Int:
+		{
+			int64_t     result;
+			if ( !CheckedMultiply( InLeft.intValue, InRight.intValue, result ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				return;
+			}
+			OutResult.SetInt( result );
+			break;
+		}
+
+		case SVT_Bool:      OutResult.SetBool( InLeft.boolValue * InRight.boolValue ); break;
+		case SVT_Double:    OutResult.SetDouble( InLeft.doubleValue * InRight.doubleValue ); break;
+		default:
+			assert( false );
+			break;
+		}
+	}
 
-		if ( InLeft->varType != InRight->varType )
+	static void DivideInto( FScriptVar& OutResult, const FScriptVar& InLeft, const FScriptVar& InRight )
+	{
+		if ( InLeft.varType != InRight.varType )
 		{
-			return result;
+			return;
 		}
 
-		switch ( InLeft->varType )
+		switch ( InLeft.varType )
 		{
-		case SVT_String:    result->SetString( "Not supported operation" ); break;
-		case SVT_Int:       result->SetInt( InLeft->GetInt() / InRight->GetInt() ); break;
-		case SVT_Bool:      result->SetBool( InLeft->GetBool() / InRight->GetBool() ); break;
+		case SVT_String:    OutResult.SetString( "Not supported operation" ); break;
+		case SVT_Int:
+			if ( InRight.intValue == 0 )
+			{
+				GExecutionState.error = EE_DivideByZero;
+				return;
+			}
+			else if ( InLeft.intValue == INT64_MIN && InRight.intValue == -1 )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				return;
+			}
+			OutResult.SetInt( InLeft.intValue / InRight.intValue );
+			break;
+
+		case SVT_Bool:      OutResult.SetBool( InLeft.boolValue / InRight.boolValue ); break;
+		case SVT_Double:    OutResult.SetDouble( InLeft.doubleValue / InRight.doubleValue ); break;
 		default:
 			assert( false );
-			return result;
+			break;
 		}
+	}
 
-		return result;
+	std::size_t GetHash() const
+	{
+		std::size_t     hash = 0;
+		switch ( varType )
+		{
+		case SVT_String:    hash = MemFastHash( stringValue.data(), stringValue.size() * sizeof( char ) ); break;
+		case SVT_Int:       hash = MemFastHash( &intValue, sizeof( int64_t ) ); break;
+		case SVT_Bool:      hash = MemFastHash( &boolValue, sizeof( bool ) ); break;
+		case SVT_Double:    hash = MemFastHash( &doubleValue, sizeof( double ) ); break;
+		case SVT_None:      break;
+		}
+		return MemFastHash( &varType, sizeof( EScriptVarType ), hash );
 	}
 
-	bool Compare( std::shared_ptr<FScriptVar> InRight ) const
+	bool Compare( const FScriptVar& InRight ) const
 	{
-		if ( varType != InRight->varType )
+		if ( varType != InRight.varType )
 		{
 			return false;
 		}
 
 		switch ( varType )
 		{
-		case SVT_String:    return GetString() == InRight->GetString();
-		case SVT_Int:       return GetInt() == InRight->GetInt();
-		case SVT_Bool:      return GetBool() == InRight->GetBool();
+		case SVT_String:    return CompareString( InRight );
+		case SVT_Int:       return intValue == InRight.intValue;
+		case SVT_Bool:      return boolValue == InRight.boolValue;
+		case SVT_Double:    return doubleValue == InRight.doubleValue;
 		default:
 			assert( false );
 			return false;
 		}
 	}
 
-	bool More( std::shared_ptr<FScriptVar> InRight ) const
+	bool CompareString( const FScriptVar& InRight ) const
 	{
-		if ( varType != InRight->varType )
+		assert( varType == SVT_String && InRight.varType == SVT_String );
+		if ( internedString && InRight.internedString )
+		{
+			return internedString == InRight.internedString;
+		}
+		return stringValue == InRight.stringValue;
+	}
+
+	bool More( const FScriptVar& InRight ) const
+	{
+		if ( varType != InRight.varType )
 		{
 			return false;
 		}
 
 		switch ( varType )
 		{
-		case SVT_String:    return GetString() > InRight->GetString();
-		case SVT_Int:       return GetInt() > InRight->GetInt();
-		case SVT_Bool:      return GetBool() > InRight->GetBool();
+		case SVT_String:    return stringValue > InRight.stringValue;
+		case SVT_Int:       return intValue > InRight.intValue;
+		case SVT_Bool:      return boolValue > InRight.boolValue;
+		case SVT_Double:    return doubleValue > InRight.doubleValue;
 		default:
 			assert( false );
 			return false;
 		}
 	}
 
-	bool MoreThen( std::shared_ptr<FScriptVar> InRight ) const
+	bool MoreThen( const FScriptVar& InRight ) const
 	{
-		if ( varType != InRight->varType )
+		if ( varType != InRight.varType )
 		{
 			return false;
 		}
 
 		switch ( varType )
 		{
-		case SVT_String:    return GetString() >= InRight->GetString();
-		case SVT_Int:       return GetInt() >= InRight->GetInt();
-		case SVT_Bool:      return GetBool() >= InRight->GetBool();
+		case SVT_String:    return stringValue >= InRight.stringValue;
+		case SVT_Int:       return intValue >= InRight.intValue;
+		case SVT_Bool:      return boolValue >= InRight.boolValue;
+		case SVT_Double:    return doubleValue >= InRight.doubleValue;
 		default:
 			assert( false );
 			return false;
 		}
 	}
 
-	bool Less( std::shared_ptr<FScriptVar> InRight ) const
+	bool Less( const FScriptVar& InRight ) const
 	{
-		if ( varType != InRight->varType )
+		if ( varType != InRight.varType )
 		{
 			return false;
 		}
 
 		switch ( varType )
 		{
-		case SVT_String:    return GetString() < InRight->GetString();
-		case SVT_Int:       return GetInt() < InRight->GetInt();
-		case SVT_Bool:      return GetBool() < InRight->GetBool();
+		case SVT_String:    return stringValue < InRight.stringValue;
+		case SVT_Int:       return intValue < InRight.intValue;
+		case SVT_Bool:      return boolValue < InRight.boolValue;
+		case SVT_Double:    return doubleValue < InRight.doubleValue;
 		default:
 			assert( false );
 			return false;
 		}
 	}
 
-	bool LessThen( std::shared_ptr<FScriptVar> InRight ) const
+	bool LessThen( const FScriptVar& InRight ) const
 	{
-		if ( varType != InRight->varType )
+		if ( varType != InRight.varType )
 		{
 			return false;
 		}
 
 		switch ( varType )
 		{
-		case SVT_String:    return GetString() <= InRight->GetString();
-		case SVT_Int:       return GetInt() <= InRight->GetInt();
-		case SVT_Bool:      return GetBool() <= InRight->GetBool();
+		case SVT_String:    return stringValue <= InRight.stringValue;
+		case SVT_Int:       return intValue <= InRight.intValue;
+		case SVT_Bool:      return boolValue <= InRight.boolValue;
+		case SVT_Double:    return doubleValue <= InRight.doubleValue;
 		default:
 			assert( false );
 			return false;
@@ -280,61 +963,131 @@ public:
 
 	void Clear()
 	{
-		if ( !ptr )
+		if ( varType == SVT_String )
 		{
-			return;
+			stringValue.~basic_string();
 		}
 
-		switch ( varType )
+		varType = SVT_None;
+		internedString = nullptr;
+		intValue = 0;
+	}
+
+	// Take value of InOutVar without copying its string, InOutVar becomes empty
+	void Move( FScriptVar& InOutVar )
+	{
+		if ( InOutVar.varType == SVT_String && !InOutVar.internedString )
 		{
-		case SVT_String:        delete static_cast< std::string* >( ptr ); break;
-		case SVT_Int:           delete static_cast< int* >( ptr ); break;
-		case SVT_Bool:          delete static_cast< bool* >( ptr ); break;
+			SetString( std::move( InOutVar.stringValue ) );
 		}
-
-		ptr = nullptr;
+		else
+		{
+			Set( InOutVar );
+		}
+		InOutVar.Clear();
 	}
 
-	void Set( std::shared_ptr<FScriptVar> InVar )
+	void Set( const FScriptVar& InVar )
 	{
-		switch ( InVar->varType )
+		switch ( InVar.varType )
 		{
-		case SVT_String:    SetString( InVar->GetString() );    break;
-		case SVT_Int:       SetInt( InVar->GetInt() );          break;
-		case SVT_Bool:      SetBool( InVar->GetBool() );          break;
+		case SVT_String:
+			if ( InVar.internedString )
+			{
+				SetInternedString( InVar.internedString );
+			}
+			else
+			{
+				SetString( InVar.stringValue );
+			}
+			break;
+
+		case SVT_Int:       SetInt( InVar.intValue );           break;
+		case SVT_Bool:      SetBool( InVar.boolValue );         break;
+		case SVT_Double:    SetDouble( InVar.doubleValue );     break;
+		case SVT_None:      Clear();                            break;
 		}
 	}
 
 	void SetString( const std::string& InStr )
 	{
-		if ( varType != SVT_String )
+		if ( !IsStringFit( InStr.size() ) )
 		{
-			Clear();
+			return;
 		}
 
-		if ( !IsValid() )
+		if ( varType != SVT_String )
 		{
-			ptr = new std::string();
+			Clear();
+			new( &stringValue ) std::string( InStr );
 			varType = SVT_String;
+			return;
 		}
 
-		*static_cast< std::string* >( ptr ) = InStr;
+		stringValue = InStr;
+		internedString = nullptr;
 	}
 
-	void SetInt( int InValue )
+	void SetString( const char* InStr, std::size_t InLength )
 	{
-		if ( varType != SVT_Int )
+		if ( !IsStringFit( InLength ) )
 		{
-			Clear();
+			return;
 		}
 
-		if ( !IsValid() )
+		if ( varType != SVT_String )
 		{
-			ptr = new int;
+			Clear();
+			new( &stringValue ) std::string( InStr, InLength );
+			varType = SVT_String;
+			return;
+		}
+
+		stringValue.assign( InStr, InLength );
+		internedString = nullptr;
+	}
+
+	void SetString( std::string&& InStr )
+	{
+		if ( varType != SVT_String )
+		{
+			Clear();
+			new( &stringValue ) std::string( std::move( InStr ) );
+			varType = SVT_String;
+			return;
+		}
+
+		stringValue = std::move( InStr );
+		internedString = nullptr;
+	}
+
+	void SetInternedString( const std::string* InStr )
+	{
+		assert( InStr );
+		if ( varType == SVT_String && internedString == InStr )
+		{
+			return;
+		}
+
+		// Refused write keeps old value, which mustn't be taken for interned string
+		if ( !IsStringFit( InStr->size() ) )
+		{
+			return;
+		}
+
+		SetString( *InStr );
+		internedString = InStr;
+	}
+
+	void SetInt( int64_t InValue )
+	{
+		if ( varType != SVT_Int )
+		{
+			Clear();
 			varType = SVT_Int;
 		}
 
-		*static_cast< int* >( ptr ) = InValue;
+		intValue = InValue;
 	}
 
 	void SetBool( bool InValue )
@@ -342,15 +1095,51 @@ public:
 		if ( varType != SVT_Bool )
 		{
 			Clear();
+			varType = SVT_Bool;
 		}
 
-		if ( !IsValid() )
+		boolValue = InValue;
+	}
+
+	void SetDouble( double InValue )
+	{
+		if ( varType != SVT_Double )
 		{
-			ptr = new bool;
-			varType = SVT_Bool;
+			Clear();
+			varType = SVT_Double;
+		}
+
+		doubleValue = InValue;
+	}
+
+	// In zero-allocation mode string can't grow beyond its capacity, a refused write is reported through GExecutionState
+	bool IsStringFit( std::size_t InLength )
+	{
+		if ( !GExecutionState.isNoAllocation )
+		{
+			return true;
+		}
+
+		static const std::size_t        emptyStringCapacity = std::string().capacity();
+		if ( InLength <= ( varType == SVT_String ? stringValue.capacity() : emptyStringCapacity ) )
+		{
+			return true;
 		}
 
-		*static_cast< bool* >( ptr ) = InValue;
+		GExecutionState.error = EE_MemoryLimit;
+		return false;
+	}
+
+	// Size of string payload in heap
+	static std::size_t GetHeapBytes( const std::string& InStr )
+	{
+		static const std::size_t        emptyStringCapacity = std::string().capacity();
+		return InStr.capacity() > emptyStringCapacity ? InStr.capacity() + 1 : 0;
+	}
+
+	std::size_t GetHeapBytes() const
+	{
+		return varType == SVT_String ? GetHeapBytes( stringValue ) : 0;
 	}
 
 	EScriptVarType GetType() const
@@ -358,75 +1147,440 @@ public:
 		return varType;
 	}
 
-	std::string GetString() const
+	const std::string& GetString() const
 	{
-		if ( !IsValid() || varType != SVT_String )
+		static const std::string        emptyString;
+		if ( varType != SVT_String )
 		{
-			return "";
+			return emptyString;
 		}
-		return *static_cast< std::string* >( ptr );
+		return stringValue;
 	}
 
-	int GetInt() const
+	int64_t GetInt() const
 	{
-		if ( !IsValid() || varType != SVT_Int )
+		if ( varType != SVT_Int )
 		{
 			return 0;
 		}
-		return *static_cast< int* >( ptr );
+		return intValue;
 	}
 
 	bool GetBool() const
 	{
-		if ( !IsValid() || varType != SVT_Bool )
+		if ( varType != SVT_Bool )
 		{
 			return 0;
 		}
-		return *static_cast< bool* >( ptr );
+		return boolValue;
+	}
+
+	double GetDouble() const
+	{
+		if ( varType != SVT_Double )
+		{
+			return 0.0;
+		}
+		return doubleValue;
+	}
+
+	// Unchecked access to value for type specialized operations, type must be proven by compiler
+	int64_t& GetIntRef()
+	{
+		assert( varType == SVT_Int );
+		return intValue;
+	}
+
+	double& GetDoubleRef()
+	{
+		assert( varType == SVT_Double );
+		return doubleValue;
+	}
+
+	const int64_t& GetIntRef() const
+	{
+		assert( varType == SVT_Int );
+		return intValue;
+	}
+
+	const double& GetDoubleRef() const
+	{
+		assert( varType == SVT_Double );
+		return doubleValue;
 	}
 
 	bool IsValid() const
 	{
-		return ptr;
+		return varType != SVT_None;
 	}
 
 private:
 	EScriptVarType      varType;
-	void* ptr;
+	const std::string*  internedString;     // Entry in string table of translator if string value is interned, otherwise nullptr
+
+	// Value is stored inline, the active member is selected by varType
+	union
+	{
+		int64_t         intValue;
+		bool            boolValue;
+		double          doubleValue;
+		std::string     stringValue;    // Short strings are kept in the small-string buffer of std::string
+	};
 };
 
+class FScriptStack;
+class FFunction;
+class FCTranslator;
+
 struct FFrame
 {
-	std::vector<std::shared_ptr<FScriptVar>>    vars;
-	std::vector<std::shared_ptr<FScriptVar>>    args;
+	FFrame()
+		: vars( nullptr ), args( nullptr ), operands( nullptr ), numArgs( 0 ), stack( nullptr )
+	{
+	}
+
+	FScriptVar*         vars;       // Local variables, followed by registers
+	FScriptVar**        args;       // Arguments, point to variables of caller or to constants which callee doesn't write
+	const FScriptVar**  operands;   // Operands of linked byte code, constants are read-only
+	int                 numArgs;    // Number of arguments
+	FScriptStack*       stack;      // Stack of current execution
+};
+
+// Active call of script function, kept on call stack of execution instead of native stack
+struct FCallRecord
+{
+	FFunction*          function;           // Called function
+	FFrame              frame;              // Frame of called function
+	int                 returnPosition;     // Position in byte code of caller to continue after return
+	int                 numArgValues;       // Values of arguments copied from constants or frame of tail caller, they are below frame
+};
+
+// Contiguous stack of values for one script execution, frames are windows into it
+class FScriptStack
+{
+public:
+	FScriptStack( int InMaxNumValues = 4096, int InMaxNumArgs = 4096, int InMaxNumCalls = 1024 )
+		: values( InMaxNumValues ), args( InMaxNumArgs ), operands( InMaxNumArgs ), calls( InMaxNumCalls ), numUsedValues( 0 ), numUsedArgs( 0 ), numUsedOperands( 0 ), numCalls( 0 ), numFrames( 0 ), maxNumValues( InMaxNumValues ), maxNumFrames( 0 ), peakNumValues( 0 ), peakNumArgs( 0 ), peakNumFrames( 0 )
+	{
+	}
+
+	// Prepare stack for new execution, limits equal to 0 mean no limit
+	void Reset( int InMaxNumValues, int InMaxNumFrames )
+	{
+		assert( numUsedValues == 0 && numUsedArgs == 0 && numUsedOperands == 0 && numCalls == 0 && numFrames == 0 );
+		maxNumValues = InMaxNumValues > 0 && InMaxNumValues < values.size() ? InMaxNumValues : values.size();
+		maxNumFrames = InMaxNumFrames;
+		peakNumValues = 0;
+		peakNumArgs = 0;
+		peakNumFrames = 0;
+	}
+
+	// Push values of frame on stack, return nullptr if stack overflow
+	FScriptVar* PushValues( int InNumValues )
+	{
+		if ( numUsedValues + InNumValues > maxNumValues || ( maxNumFrames > 0 && numFrames + 1 > maxNumFrames ) )
+		{
+			return nullptr;
+		}
+
+		FScriptVar*     result = values.data() + numUsedValues;
+		numUsedValues += InNumValues;
+		++numFrames;
+		peakNumValues = std::max( peakNumValues, numUsedValues );
+		peakNumFrames = std::max( peakNumFrames, numFrames );
+		return result;
+	}
+
+	void PopValues( int InNumValues )
+	{
+		assert( InNumValues <= numUsedValues && numFrames > 0 );
+		for ( int i = numUsedValues - InNumValues; i < numUsedValues; ++i )
+		{
+			values[ i ].Clear();
+		}
+		numUsedValues -= InNumValues;
+		--numFrames;
+	}
+
+	// Pop values of top frame starting at InFrameValues for tail call. Values of frame referenced by InOutArgs are copied
+	// to beginning of frame and stay on stack without frame, InOutArgs point to them. Return number of kept values, -1 if stack overflow
+	int PopValuesForTailCall( FScriptVar* InFrameValues, FScriptVar** InOutArgs, int InNumArgs )
+	{
+		assert( numFrames > 0 );
+		FScriptVar*     top = values.data() + numUsedValues;
+		int             numKeptValues = 0;
+		for ( int i = 0; i < InNumArgs; ++i )
+		{
+			if ( InOutArgs[ i ] >= InFrameValues && InOutArgs[ i ] < top )
+			{
+				++numKeptValues;
+			}
+		}
+
+		if ( numUsedValues + numKeptValues > maxNumValues )
+		{
+			return -1;
+		}
+
+		// Copy above top first, destination of arguments may overlap their sources
+		for ( int i = 0, j = 0; i < InNumArgs; ++i )
+		{
+			if ( InOutArgs[ i ] >= InFrameValues && InOutArgs[ i ] < top )
+			{
+				top[ j ].Set( *InOutArgs[ i ] );
+				InOutArgs[ i ] = InFrameValues + j;
+				++j;
+			}
+		}
+
+		for ( int j = 0; j < numKeptValues; ++j )
+		{
+			InFrameValues[ j ].Move( top[ j ] );
+		}
+
+		for ( FScriptVar* value = InFrameValues + numKeptValues; value < top; ++value )
+		{
+			value->Clear();
+		}
+
+		peakNumValues = std::max( peakNumValues, numUsedValues + numKeptValues );
+		numUsedValues = InFrameValues + numKeptValues - values.data();
+		--numFrames;
+		return numKeptValues;
+	}
+
+	// Push values of arguments without frame, return nullptr if stack overflow
+	FScriptVar* PushArgValues( int InNumValues )
+	{
+		if ( numUsedValues + InNumValues > maxNumValues )
+		{
+			return nullptr;
+		}
+
+		FScriptVar*     result = values.data() + numUsedValues;
+		numUsedValues += InNumValues;
+		peakNumValues = std::max( peakNumValues, numUsedValues );
+		return result;
+	}
+
+	// Pop values pushed by PushArgValues or kept by PopValuesForTailCall
+	void PopArgValues( int InNumValues )
+	{
+		assert( InNumValues <= numUsedValues );
+		for ( int i = numUsedValues - InNumValues; i < numUsedValues; ++i )
+		{
+			values[ i ].Clear();
+		}
+		numUsedValues -= InNumValues;
+	}
+
+	// Push arguments on stack, return nullptr if stack overflow
+	FScriptVar** PushArgs( int InNumArgs )
+	{
+		if ( numUsedArgs + InNumArgs > args.size() )
+		{
+			return nullptr;
+		}
+
+		FScriptVar**    result = args.data() + numUsedArgs;
+		numUsedArgs += InNumArgs;
+		peakNumArgs = std::max( peakNumArgs, numUsedArgs + numUsedOperands );
+		return result;
+	}
+
+	void PopArgs( int InNumArgs )
+	{
+		assert( InNumArgs <= numUsedArgs );
+		numUsedArgs -= InNumArgs;
+	}
+
+	// Push operand table of frame, return nullptr if stack overflow
+	const FScriptVar** PushOperands( int InNumOperands )
+	{
+		if ( numUsedOperands + InNumOperands > operands.size() )
+		{
+			return nullptr;
+		}
+
+		const FScriptVar**  result = operands.data() + numUsedOperands;
+		numUsedOperands += InNumOperands;
+		peakNumArgs = std::max( peakNumArgs, numUsedArgs + numUsedOperands );
+		return result;
+	}
+
+	void PopOperands( int InNumOperands )
+	{
+		assert( InNumOperands <= numUsedOperands );
+		numUsedOperands -= InNumOperands;
+	}
+
+	// Push record of script call, return nullptr if call stack is full
+	FCallRecord* PushCall()
+	{
+		if ( numCalls == calls.size() )
+		{
+			return nullptr;
+		}
+
+		FCallRecord&    call = calls[ numCalls++ ];
+		call.frame = FFrame();
+		call.numArgValues = 0;
+		return &call;
+	}
+
+	void PopCall()
+	{
+		assert( numCalls > 0 );
+		--numCalls;
+	}
+
+	FCallRecord& GetTopCall()
+	{
+		assert( numCalls > 0 );
+		return calls[ numCalls - 1 ];
+	}
+
+	int GetNumCalls() const
+	{
+		return numCalls;
+	}
+
+	int GetMaxNumValues() const
+	{
+		return values.size();
+	}
+
+	int GetMaxNumArgs() const
+	{
+		return args.size();
+	}
+
+	int GetPeakNumValues() const
+	{
+		return peakNumValues;
+	}
+
+	int GetPeakNumArgs() const
+	{
+		return peakNumArgs;
+	}
+
+	int GetPeakNumFrames() const
+	{
+		return peakNumFrames;
+	}
+
+	std::size_t GetMemoryBytes() const
+	{
+		return values.capacity() * sizeof( FScriptVar ) + args.capacity() * sizeof( FScriptVar* ) + operands.capacity() * sizeof( const FScriptVar* ) + calls.capacity() * sizeof( FCallRecord );
+	}
+
+private:
+	std::vector<FScriptVar>         values;         // Local variables of all frames
+	std::vector<FScriptVar*>        args;           // Arguments of all frames
+	std::vector<const FScriptVar*>  operands;       // Operand tables of all frames
+	std::vector<FCallRecord>        calls;          // Active script calls, preallocated so push and pop never allocate
+	int                             numUsedValues;  // Number of used values
+	int                             numUsedArgs;    // Number of used arguments
+	int                             numUsedOperands;    // Number of used operands
+	int                             numCalls;       // Number of active script calls
+	int                             numFrames;      // Number of frames
+	int                             maxNumValues;   // Limit of used values
+	int                             maxNumFrames;   // Limit of frames, 0 - no limit
+	int                             peakNumValues;  // Peak number of used values in current execution
+	int                             peakNumArgs;    // Peak number of used arguments and operands in current execution
+	int                             peakNumFrames;  // Peak number of frames in current execution
+};
+
+// Stacks of finished executions, reused by next executions on the same thread
+class FScriptStackPool
+{
+public:
+	FScriptStack* Acquire()
+	{
+		if ( freeStacks.empty() )
+		{
+			return new FScriptStack();
+		}
+
+		FScriptStack*       stack = freeStacks.back().release();
+		freeStacks.pop_back();
+		return stack;
+	}
+
+	void Release( FScriptStack* InStack )
+	{
+		assert( InStack );
+		freeStacks.push_back( std::unique_ptr<FScriptStack>( InStack ) );
+	}
+
+	int GetNumStacks() const
+	{
+		return freeStacks.size();
+	}
+
+	std::size_t GetMemoryBytes() const
+	{
+		std::size_t     numBytes = 0;
+		for ( int i = 0; i < freeStacks.size(); ++i )
+		{
+			numBytes += freeStacks[ i ]->GetMemoryBytes();
+		}
+		return numBytes;
+	}
+
+	// Preallocate stacks, so next InNumStacks executions don't allocate it
+	void Reserve( int InNumStacks )
+	{
+		freeStacks.reserve( InNumStacks );
+		while ( freeStacks.size() < InNumStacks )
+		{
+			freeStacks.push_back( std::unique_ptr<FScriptStack>( new FScriptStack() ) );
+		}
+	}
+
+private:
+	std::vector<std::unique_ptr<FScriptStack>>      freeStacks;
 };
 
+thread_local FScriptStackPool       GScriptStackPool;
+
 // Native functions
 typedef void ( *FNativeFunctionFn )( FFrame& );
 
 void execPrint( FFrame& InFrame )
 {
-	if ( InFrame.args.empty() )
+	if ( InFrame.numArgs == 0 )
 	{
 		return;
 	}
 
-	for ( int i = 0; i < InFrame.args.size(); ++i )
+	for ( int i = 0; i < InFrame.numArgs; ++i )
 	{
-		std::shared_ptr<FScriptVar>       argItem = InFrame.args[ i ];
+		FScriptVar*     argItem = InFrame.args[ i ];
 		switch ( argItem->GetType() )
 		{
 		case SVT_String:
-			printf( "%s", argItem->GetString().c_str() );
+		{
+			const std::string&      str = argItem->GetString();
+			fwrite( str.data(), sizeof( char ), str.size(), stdout );
 			break;
+		}
 
 		case SVT_Int:
-			printf( "%i", argItem->GetInt() );
+			printf( "%lld", ( long long ) argItem->GetInt() );
 			break;
 
 		case SVT_Bool:
 			printf( "%i", argItem->GetBool() );
 			break;
+
+		case SVT_Double:
+			printf( "%g", argItem->GetDouble() );
+			break;
+
+		case SVT_None:
+			break;
 		}
 
 		printf( " " );
@@ -437,27 +1591,29 @@ void execPrint( FFrame& InFrame )
 
 void execScan( FFrame& InFrame )
 {
-	if ( InFrame.args.empty() )
+	if ( InFrame.numArgs == 0 )
 	{
 		return;
 	}
 
-	for ( int i = 0; i < InFrame.args.size(); ++i )
+	for ( int i = 0; i < InFrame.numArgs; ++i )
 	{
-		std::shared_ptr<FScriptVar>   argItem = InFrame.args[ i ];
+		FScriptVar*     argItem = InFrame.args[ i ];
 		switch ( argItem->GetType() )
 		{
 		case SVT_String:
 		{
-			std::string     var;
+			// Word is read in buffer on native stack, so scan doesn't allocate temporary string
+			char    var[ 256 ];
+			std::cin.width( sizeof( var ) );
 			std::cin >> var;
-			argItem->SetString( var );
+			argItem->SetString( var, strlen( var ) );
 			break;
 		}
 
 		case SVT_Int:
 		{
-			int var;
+			long long var;
 			std::cin >> var;
 			argItem->SetInt( var );
 			break;
@@ -470,6 +1626,17 @@ void execScan( FFrame& InFrame )
 			argItem->SetBool( var );
 			break;
 		}
+
+		case SVT_Double:
+		{
+			double var;
+			std::cin >> var;
+			argItem->SetDouble( var );
+			break;
+		}
+
+		case SVT_None:
+			break;
 		}
 	}
 }
@@ -681,6 +1848,7 @@ enum ESubTokenType
 	STT_If,
 	STT_Else,
 	STT_While,
+	STT_Return,
 	STT_Not,
 
 	// Delimeters
@@ -728,6 +1896,7 @@ std::string SubtokenTypeToText( ESubTokenType InSubokenType )
 	case STT_If:                return "If";
 	case STT_Else:              return "Else";
 	case STT_While:             return "While";
+	case STT_Return:            return "Return";
 	case STT_Not:				return "Not";
 	case STT_BeginArgs:         return "BeginArgs";
 	case STT_EndArgs:           return "EndArgs";
@@ -755,6 +1924,9 @@ EScriptVarType SubtokenTypeToScriptVarType( ESubTokenType InSubokenType )
 	case STT_String:
 		return SVT_String;
 
+	case STT_Float:
+		return SVT_Double;
+
 	default:
 		return SVT_None;
 	}
@@ -793,7 +1965,7 @@ ESubTokenType GetSubtokenInDelimeter( char ch )
 
 ESubTokenType GetSubtokenInKeyword( char* str )
 {
-	if ( !strcmp( str, "int" ) )
+	if ( !strcmp( str, "int" ) || !strcmp( str, "long" ) )
 	{
 		return STT_Integer;
 	}
@@ -817,6 +1989,10 @@ ESubTokenType GetSubtokenInKeyword( char* str )
 	{
 		return STT_While;
 	}
+	else if ( !strcmp( str, "return" ) )
+	{
+		return STT_Return;
+	}
 
 	return STT_None;
 }
@@ -844,9 +2020,14 @@ struct FToken
 		}
 	};
 
+	std::string GetOriginalView() const
+	{
+		return std::string( view, length );
+	}
+
 	std::size_t GetHash() const
 	{
-		std::size_t        hash = MemFastHash( originalView.data(), originalView.size() * sizeof( char ) );
+		std::size_t        hash = MemFastHash( view, length * sizeof( char ) );
 		MemFastHash( &type, sizeof( ETokenType ), hash );
 		MemFastHash( &subType, sizeof( ESubTokenType ), hash );
 		return hash;
@@ -855,30 +2036,85 @@ struct FToken
 	unsigned int        id;             // ID of token
 	unsigned int        row;            // Row of start token in file
 	unsigned int        column;         // Column of start token in file
-	std::string         originalView;   // Original view in source code
+	const char*         view;           // Original view, points to retained source code
+	unsigned int        length;         // Length of original view
 	ETokenType          type;           // Type
 	ESubTokenType       subType;        // Subtype
 };
 
-struct FSemanticItem
+// Token stream stored as structure of arrays, views of tokens point to retained source code
+class FTokenStream
 {
-	FSemanticItem( ETokenType TokenType, ESubTokenType SubTokenType, int InNumPlacableTokens = 0, bool InAnySubType = false, bool InIsOptional = false )
-		: type( TokenType ), subType( SubTokenType ), numPlacableTokens( InNumPlacableTokens ), anySubType( InAnySubType ), isOptional( InIsOptional )
+public:
+	void push_back( const FToken& InToken )
 	{
+		ids.push_back( InToken.id );
+		rows.push_back( InToken.row );
+		columns.push_back( InToken.column );
+		views.push_back( InToken.view );
+		lengths.push_back( InToken.length );
+		types.push_back( ( unsigned char ) InToken.type );
+		subTypes.push_back( ( unsigned char ) InToken.subType );
 	}
 
-	bool Match( const FToken& InToken, bool InIsIgnoreOpetionalFlag = false ) const
+	FToken operator[]( int InIndex ) const
 	{
-		return ( !InIsIgnoreOpetionalFlag && isOptional ) || numPlacableTokens > 0 || numPlacableTokens == -1 || type == InToken.type && ( anySubType || subType == InToken.subType );
+		FToken      token;
+		token.id = ids[ InIndex ];
+		token.row = rows[ InIndex ];
+		token.column = columns[ InIndex ];
+		token.view = views[ InIndex ];
+		token.length = lengths[ InIndex ];
+		token.type = ( ETokenType ) types[ InIndex ];
+		token.subType = ( ESubTokenType ) subTypes[ InIndex ];
+		return token;
 	}
 
-	bool                anySubType;
-	bool                isOptional;
-	int                 numPlacableTokens;  // Number of placable tokens. If -1 end of placable when end delimeter (ex. { and } )
-	ETokenType          type;               // Type
-	ESubTokenType       subType;            // Subtype
-};
-
+	int size() const
+	{
+		return types.size();
+	}
+
+	bool empty() const
+	{
+		return types.empty();
+	}
+
+	std::size_t GetMemoryBytes() const
+	{
+		return ids.capacity() * sizeof( unsigned int ) + rows.capacity() * sizeof( unsigned int ) + columns.capacity() * sizeof( unsigned int ) +
+			views.capacity() * sizeof( const char* ) + lengths.capacity() * sizeof( unsigned int ) + types.capacity() + subTypes.capacity();
+	}
+
+private:
+	std::vector<unsigned int>       ids;        // IDs of tokens
+	std::vector<unsigned int>       rows;       // Rows of start tokens in file
+	std::vector<unsigned int>       columns;    // Columns of start tokens in file
+	std::vector<const char*>        views;      // Original views in source code
+	std::vector<unsigned int>       lengths;    // Lengths of original views
+	std::vector<unsigned char>      types;      // Types
+	std::vector<unsigned char>      subTypes;   // Subtypes
+};
+
+struct FSemanticItem
+{
+	FSemanticItem( ETokenType TokenType, ESubTokenType SubTokenType, int InNumPlacableTokens = 0, bool InAnySubType = false, bool InIsOptional = false )
+		: type( TokenType ), subType( SubTokenType ), numPlacableTokens( InNumPlacableTokens ), anySubType( InAnySubType ), isOptional( InIsOptional )
+	{
+	}
+
+	bool Match( const FToken& InToken, bool InIsIgnoreOpetionalFlag = false ) const
+	{
+		return ( !InIsIgnoreOpetionalFlag && isOptional ) || numPlacableTokens > 0 || numPlacableTokens == -1 || type == InToken.type && ( anySubType || subType == InToken.subType );
+	}
+
+	bool                anySubType;
+	bool                isOptional;
+	int                 numPlacableTokens;  // Number of placable tokens. If -1 end of placable when end delimeter (ex. { and } )
+	ETokenType          type;               // Type
+	ESubTokenType       subType;            // Subtype
+};
+
 struct FDeclFunctionSemanticInfo
 {
 	FDeclFunctionSemanticInfo()
@@ -968,25 +2204,94 @@ struct FCompareSemanticInfo
 	bool    isRightConstVar;
 };
 
+// Memory needs of script function, computed before execution
+struct FPreflightInfo
+{
+	FPreflightInfo()
+		: numValues( 0 ), numArgs( 0 ), callDepth( 0 )
+	{
+	}
+
+	int     numValues;      // Max number of stack values
+	int     numArgs;        // Max number of stack arguments
+	int     callDepth;      // Max depth of calls
+};
+
+// Options of script execution, limits equal to 0 mean no limit
+struct FExecuteOptions
+{
+	FExecuteOptions()
+		: isNoAllocation( false ), maxNumValues( 0 ), maxCallDepth( 0 ), maxHeapBytes( 0 )
+	{
+	}
+
+	bool            isNoAllocation;     // Fail operations which need heap memory
+	int             maxNumValues;       // Max number of stack values
+	int             maxCallDepth;       // Max depth of calls
+	std::size_t     maxHeapBytes;       // Max heap bytes allocated by execution (string payloads), needs SCRIPT_HEAP_STATS
+};
+
+// Statistics of one script execution
+struct FExecutionStats
+{
+	FExecutionStats()
+		: numValues( 0 ), numArgs( 0 ), callDepth( 0 ), numHeapAllocations( 0 ), numHeapBytes( 0 )
+	{
+	}
+
+	int             numValues;              // Peak number of stack values
+	int             numArgs;                // Peak number of stack arguments
+	int             callDepth;              // Peak depth of calls
+	std::size_t     numHeapAllocations;     // Number of heap allocations, 0 without SCRIPT_HEAP_STATS
+	std::size_t     numHeapBytes;           // Heap bytes allocated, 0 without SCRIPT_HEAP_STATS
+};
+
+// Memory used by loaded scripts
+struct FMemoryStats
+{
+	FMemoryStats()
+		: numTokens( 0 ), tokensBytes( 0 ), numConstants( 0 ), constantsBytes( 0 ), numFunctions( 0 ), byteCodeBytes( 0 ), numStrings( 0 ), stringsBytes( 0 ), numStacks( 0 ), stacksBytes( 0 )
+	{
+	}
+
+	std::size_t     numTokens;          // Number of tokens
+	std::size_t     tokensBytes;        // Memory of tokens and retained source code
+	std::size_t     numConstants;       // Number of var constants
+	std::size_t     constantsBytes;     // Memory of var constants
+	std::size_t     numFunctions;       // Number of script functions
+	std::size_t     byteCodeBytes;      // Memory of byte code
+	std::size_t     numStrings;         // Number of interned strings
+	std::size_t     stringsBytes;       // Memory of interned strings
+	std::size_t     numStacks;          // Number of free execution stacks of current thread
+	std::size_t     stacksBytes;        // Memory of free execution stacks of current thread
+};
+
 class FFunction
 {
 public:
-	FFunction( const std::string& InName, const std::vector<int>& InCode )
-		: name( InName ), code( InCode )
+	FFunction( const std::string& InName, const std::vector<int>& InCode, int InNumVars, int InNumRegisters )
+		: name( InName ), code( InCode ), numVars( InNumVars ), numRegisters( InNumRegisters )
 	{
 	}
 
 	FFunction( const FFunction& InCopy )
-		: name( InCopy.name ), code( InCopy.code )
+		: name( InCopy.name ), code( InCopy.code ), linkedCode( InCopy.linkedCode ), operandSources( InCopy.operandSources ), constants( InCopy.constants ), callTargets( InCopy.callTargets ), writtenArgs( InCopy.writtenArgs ), numVars( InCopy.numVars ), numRegisters( InCopy.numRegisters )
 	{
 	}
 
-	void Execute( FFrame& InFrame );
+	bool Execute( FFrame& InFrame );
 
 	FFunction& operator=( const FFunction& InCopy )
 	{
 		name = InCopy.name;
 		code = InCopy.code;
+		linkedCode = InCopy.linkedCode;
+		operandSources = InCopy.operandSources;
+		constants = InCopy.constants;
+		callTargets = InCopy.callTargets;
+		writtenArgs = InCopy.writtenArgs;
+		numVars = InCopy.numVars;
+		numRegisters = InCopy.numRegisters;
 		return *this;
 	}
 
@@ -995,15 +2300,198 @@ public:
 		return name;
 	}
 
+	int GetNumVars() const
+	{
+		return numVars;
+	}
+
+	int GetNumRegisters() const
+	{
+		return numRegisters;
+	}
+
+	// Arg is written by callee of function, so constant passed to it must be copied
+	bool IsArgWritten( int InArgId ) const
+	{
+		return InArgId < writtenArgs.size() && writtenArgs[ InArgId ];
+	}
+
+	// Mark args passed to callees which write them. Return true if new args were marked
+	bool UpdateWrittenArgs( const FCTranslator& InTranslator );
+
+	std::size_t GetMemoryBytes() const
+	{
+		std::size_t     numBytes = sizeof( FFunction ) + code.capacity() * sizeof( int ) + linkedCode.capacity() + operandSources.capacity() * sizeof( FOperandSource ) + constants.capacity() * sizeof( FScriptVar ) + callTargets.capacity() * sizeof( FCallTarget ) + FScriptVar::GetHeapBytes( name );
+		for ( const FScriptVar& constant : constants )
+		{
+			numBytes += constant.GetHeapBytes();
+		}
+		return numBytes;
+	}
+
+	// Call InFunc( functionId, isNative, numArgs ) for each call in byte code
+	template<typename TFunc>
+	void ForEachCall( TFunc InFunc ) const
+	{
+		for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+		{
+			if ( GetOperationFormat( code[ i ] ) == OF_Call )
+			{
+				InFunc( code[ i + 1 ], code[ i ] == Op_NativeCall, code[ i + 2 ] );
+			}
+		}
+	}
+
+	// Rewrite operands of byte code to indices in operand table of frame, so interpreter reads them without decoding var flags,
+	// copy used constants to constant table of function, resolve callees of calls and encode byte code to packed byte code. Return false if function is too large for packed byte code
+	bool Link( FCTranslator& InTranslator );
+
+	int GetNumOperands() const
+	{
+		return operandSources.size();
+	}
+
+	// Constants take first indices of operand table
+	int GetNumConstants() const
+	{
+		return constants.size();
+	}
+
+	// Call InFunc( varFlag, varId ) for each var operand in byte code
+	template<typename TFunc>
+	void ForEachVarOperand( TFunc InFunc )
+	{
+		ForEachVarOperand( code, InFunc );
+	}
+
+	template<typename TFunc>
+	static void ForEachVarOperand( std::vector<int>& InOutCode, TFunc InFunc )
+	{
+		for ( int i = 0; i < InOutCode.size(); i += GetOperationSize( &InOutCode[ i ] ) )
+		{
+			ForEachVarOperand( &InOutCode[ i ], InFunc );
+		}
+	}
+
+	// Call InFunc( varFlag, varId ) for each var operand of operation at InOutOperation
+	template<typename TFunc>
+	static void ForEachVarOperand( int* InOutOperation, TFunc InFunc )
+	{
+		int*    code = InOutOperation;
+		switch ( GetOperationFormat( code[ 0 ] ) )
+		{
+		case OF_Call:
+			for ( int j = 0; j < code[ 2 ]; ++j )
+			{
+				InFunc( code[ 3 + j * 2 ], code[ 4 + j * 2 ] );
+			}
+			break;
+
+		case OF_AllocateVar:
+			InFunc( SVF_User, code[ 2 ] );
+			break;
+
+		case OF_Binary:
+			InFunc( SVF_User, code[ 1 ] );
+			InFunc( code[ 2 ], code[ 3 ] );
+			break;
+
+		case OF_Arithmetic:
+			InFunc( SVF_Register, code[ 1 ] );
+			InFunc( SVF_User, code[ 2 ] );
+			InFunc( code[ 3 ], code[ 4 ] );
+			break;
+
+		case OF_Compare:
+		case OF_Branch:
+			InFunc( code[ 1 ], code[ 2 ] );
+			InFunc( code[ 3 ], code[ 4 ] );
+			break;
+
+		case OF_Ternary:
+			InFunc( SVF_User, code[ 1 ] );
+			InFunc( SVF_User, code[ 2 ] );
+			InFunc( code[ 3 ], code[ 4 ] );
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// Replace generic operations with type specialized ones where types of operands are known at compile time
+	void SpecializeTypes( const FCTranslator& InTranslator );
+
+	// Fuse typed arithmetic with following assign and compare with following branch
+	void FuseOperations();
+
+	// Thread jumps through Op_Nope landing pads and chains of jumps, then delete landing pads and useless jumps
+	void OptimizeJumps();
+
+	// Map virtual registers of compiler to registers of frame with linear scan over their live intervals
+	void AllocateRegisters();
+
+	// Replace script calls followed by Op_Return with tail calls. Must run after OptimizeJumps, which removes jumps between them
+	void EliminateTailCalls();
+
+	// Print to console byte code of function
+	void DumpByteCode( const FCTranslator& InTranslator ) const;
+
 private:
-	std::string         name;
-	std::vector<int>	code;
+	// Push frame of function on stack and resolve its operand table
+	bool EnterFrame( FFrame& InFrame );
+	void LeaveFrame( FFrame& InFrame );
+
+	// Interpreter loop, script calls from InFrame run in the same loop on call stack of execution
+	template<bool InIsThreaded>
+	bool ExecuteCode( FFrame& InFrame );
+	void ReportExecutionError() const;
+
+	// Print operand of operand table, constants are printed with value
+	void DumpOperand( int InOperand ) const;
+
+	struct FCallTarget;
+
+	// Copy args of call from operand table. Return number of copied values, -1 if stack overflow
+	static int CopyCallArgs( FScriptStack* InStack, FScriptVar** OutArgs, const FCallTarget& InCallTarget, const FScriptVar* const* InOperands, const uint8_t* InArgOperands, int InNumArgs, int InNumConstants );
+
+	// Source of operand in frame
+	struct FOperandSource
+	{
+		int     varFlag;
+		int     varId;
+	};
+
+	// Callee of call site, resolved at link time
+	struct FCallTarget
+	{
+		int                 functionId;
+		FFunction*          function;           // Script function, nullptr for native function
+		FNativeFunctionFn   nativeFunctionFn;   // Native function, nullptr for script function
+		bool                isWritingArgs;      // Native function writes its args
+
+		bool IsArgWritten( int InArgId ) const
+		{
+			return function ? function->IsArgWritten( InArgId ) : isWritingArgs;
+		}
+	};
+
+	std::string                     name;
+	std::vector<int>	            code;
+	std::vector<uint8_t>            linkedCode;         // Packed byte code with operands resolved to indices in operand table
+	std::vector<FOperandSource>     operandSources;     // Sources of operand table of frame, constants are indices in constant table
+	std::vector<FScriptVar>         constants;          // Constants used by function
+	std::vector<FCallTarget>        callTargets;        // Callees of call sites of packed byte code
+	std::vector<bool>               writtenArgs;        // Args written by callees, script code itself assigns only to locals
+	int                             numVars;            // Number of local variable slots in frame
+	int                             numRegisters;       // Number of register slots in frame, they follow local variables
 };
 
 struct FNativeFunction
 {
 	std::string             name;
 	FNativeFunctionFn       functionFn;
+	bool                    isWritingArgs;      // Function writes its args, otherwise it only reads them
 };
 
 class FCTranslator
@@ -1022,10 +2510,17 @@ public:
 
 		// Read all file to buffer
 		std::getline( file, buffer, '\0' );
+		return LoadFromString( buffer );
+	}
 
+	// Load source code from string
+	bool LoadFromString( std::string InSourceCode )
+	{
 		// Parse code
 		std::string     errorMsg;
-		bool    bResult = Parse( ( char* ) buffer.data(), errorMsg );
+		// Source code is retained, tokens point into it
+		sourceCodes.push_back( std::move( InSourceCode ) );
+		bool    bResult = Parse( &sourceCodes.back()[ 0 ], errorMsg );
 		if ( !bResult )
 		{
 			printf( "Error: %s", errorMsg.c_str() );
@@ -1049,11 +2544,11 @@ public:
 		for ( int i = 0; i < tokens.size(); i++ )
 		{
 			const FToken& token = tokens[ i ];
-			printf( "%i\t\t%i\t\t%i\t\t%s\t\t\t%-10s\t\t%s\n",
+			printf( "%i\t\t%i\t\t%i\t\t%.*s\t\t\t%-10s\t\t%s\n",
 					token.id,
 					token.row,
 					token.column,
-					token.originalView.c_str(),
+					( int ) token.length, token.view,
 					TokenTypeToText( token.type ).c_str(),
 					SubtokenTypeToText( token.subType ).c_str() );
 		}
@@ -1072,11 +2567,11 @@ public:
 		for ( auto it = userIdentifiers.begin(); it != userIdentifiers.end(); it++ )
 		{
 			const FToken& token = it->first;
-			printf( "%i\t\t%i\t\t%i\t\t%s\t\t\t%-10s\t\t%s\n",
+			printf( "%i\t\t%i\t\t%i\t\t%.*s\t\t\t%-10s\t\t%s\n",
 					token.id,
 					token.row,
 					token.column,
-					token.originalView.c_str(),
+					( int ) token.length, token.view,
 					TokenTypeToText( token.type ).c_str(),
 					SubtokenTypeToText( token.subType ).c_str() );
 		}
@@ -1112,56 +2607,252 @@ public:
 		}
 	}
 
+	// Register native function, scripts loaded after it can call it. Constants are passed by reference to functions
+	// which only read their args, so function writing its args must be registered with InIsWritingArgs
+	void RegisterNativeFunction( const std::string& InFuncName, FNativeFunctionFn InFn, bool InIsWritingArgs = false )
+	{
+		int     nativeFunctionId = nativeFunctions.size();
+		nativeFunctions.push_back( FNativeFunction{ InFuncName, InFn, InIsWritingArgs } );
+		nativeFunctionNameToID[ InFuncName ] = nativeFunctionId;
+	}
+
 	void Init()
 	{
 		// Register native functions
 		RegisterNativeFunction( "print", &execPrint );
-		RegisterNativeFunction( "scan", &execScan );
+		RegisterNativeFunction( "scan", &execScan, true );
 	}
 
-	void ExecuteFunction( const std::string& InFuncName, FFrame& InFrame )
+	// Execute function. Execution stops with error if it exceeds limits of InOptions,
+	// in zero-allocation mode script operations which need heap memory fail
+	bool ExecuteFunction( const std::string& InFuncName, FFrame& InFrame, const FExecuteOptions& InOptions = FExecuteOptions(), FExecutionStats* OutStats = nullptr )
 	{
 		auto    itFunc = functionNameToID.find( InFuncName );
 		if ( itFunc != functionNameToID.end() )
 		{
-			functions[ itFunc->second ].Execute( InFrame );
-			return;
+			InFrame.stack = GScriptStackPool.Acquire();
+			InFrame.stack->Reset( InOptions.maxNumValues, InOptions.maxCallDepth > 0 ? InOptions.maxCallDepth + 1 : 0 );
+
+			FExecutionState     oldExecutionState = GExecutionState;
+			GExecutionState = FExecutionState();
+			GExecutionState.isExecuting = true;
+			GExecutionState.isNoAllocation = InOptions.isNoAllocation;
+			GExecutionState.maxHeapBytes = InOptions.maxHeapBytes;
+
+			bool    bResult = functions[ itFunc->second ].Execute( InFrame );
+			if ( OutStats )
+			{
+				OutStats->numValues = InFrame.stack->GetPeakNumValues();
+				OutStats->numArgs = InFrame.stack->GetPeakNumArgs();
+				OutStats->callDepth = InFrame.stack->GetPeakNumFrames() - 1;
+				OutStats->numHeapAllocations = GExecutionState.numHeapAllocations;
+				OutStats->numHeapBytes = GExecutionState.numHeapBytes;
+			}
+			GExecutionState = oldExecutionState;
+
+			GScriptStackPool.Release( InFrame.stack );
+			InFrame.stack = nullptr;
+			return bResult;
 		}
 
 		auto    itNativeFunc = nativeFunctionNameToID.find( InFuncName );
 		if ( itNativeFunc != nativeFunctionNameToID.end() )
 		{
 			nativeFunctions[ itNativeFunc->second ].functionFn( InFrame );
+			return true;
+		}
+
+		printf( "Error: function '%s' not found\n", InFuncName.c_str() );
+		return false;
+	}
+
+	void GetMemoryStats( FMemoryStats& OutStats ) const
+	{
+		OutStats = FMemoryStats();
+		OutStats.numTokens = tokens.size();
+		OutStats.tokensBytes = tokens.GetMemoryBytes();
+		for ( auto it = sourceCodes.begin(), itEnd = sourceCodes.end(); it != itEnd; ++it )
+		{
+			OutStats.tokensBytes += it->capacity() + 1;
+		}
+
+		OutStats.numConstants = varConstants.size();
+		OutStats.constantsBytes = varConstants.capacity() * sizeof( FScriptVar );
+		for ( int i = 0; i < varConstants.size(); ++i )
+		{
+			OutStats.constantsBytes += varConstants[ i ].GetHeapBytes();
+		}
+
+		OutStats.numFunctions = functions.size();
+		for ( int i = 0; i < functions.size(); ++i )
+		{
+			OutStats.byteCodeBytes += functions[ i ].GetMemoryBytes();
+		}
+
+		OutStats.numStrings = stringTable.GetNumStrings();
+		OutStats.stringsBytes = stringTable.GetMemoryBytes();
+		OutStats.numStacks = GScriptStackPool.GetNumStacks();
+		OutStats.stacksBytes = GScriptStackPool.GetMemoryBytes();
+	}
+
+	// Print to console byte code of all functions
+	void DumpByteCode() const
+	{
+		if ( functions.empty() )
+		{
+			printf( "Functions: empty\n" );
 			return;
 		}
+
+		for ( int i = 0; i < functions.size(); ++i )
+		{
+			functions[ i ].DumpByteCode( *this );
+			printf( "\n" );
+		}
+	}
+
+	// Print to console memory used by loaded scripts
+	void DumpMemoryStats() const
+	{
+		FMemoryStats        stats;
+		GetMemoryStats( stats );
+		printf( "Tokens: %i, %i bytes\n", ( int ) stats.numTokens, ( int ) stats.tokensBytes );
+		printf( "Constants: %i, %i bytes\n", ( int ) stats.numConstants, ( int ) stats.constantsBytes );
+		printf( "Functions: %i, %i bytes of byte code\n", ( int ) stats.numFunctions, ( int ) stats.byteCodeBytes );
+		printf( "Interned strings: %i, %i bytes\n", ( int ) stats.numStrings, ( int ) stats.stringsBytes );
+		printf( "Execution stacks: %i, %i bytes\n", ( int ) stats.numStacks, ( int ) stats.stacksBytes );
+	}
+
+	// Compute memory needs of function and preallocate execution stack for current thread.
+	// Return false if function not found, recursive or doesn't fit in execution stack
+	bool Preflight( const std::string& InFuncName, FPreflightInfo& OutInfo )
+	{
+		auto    itFunc = functionNameToID.find( InFuncName );
+		if ( itFunc == functionNameToID.end() )
+		{
+			printf( "Error: function '%s' not found\n", InFuncName.c_str() );
+			return false;
+		}
+
+		std::vector<bool>       isInCallChain( functions.size(), false );
+		OutInfo = FPreflightInfo();
+		if ( !PreflightFunction( itFunc->second, isInCallChain, OutInfo ) )
+		{
+			printf( "Error: function '%s' is recursive, memory needs are unbounded\n", InFuncName.c_str() );
+			return false;
+		}
+
+		GScriptStackPool.Reserve( 1 );
+		FScriptStack*       stack = GScriptStackPool.Acquire();
+		bool                isFit = OutInfo.numValues <= stack->GetMaxNumValues() && OutInfo.numArgs <= stack->GetMaxNumArgs();
+		GScriptStackPool.Release( stack );
+		if ( !isFit )
+		{
+			printf( "Error: function '%s' doesn't fit in execution stack\n", InFuncName.c_str() );
+			return false;
+		}
+
+		return true;
 	}
 
-	void ExecuteFunction( int InFuncId, bool InIsNative, FFrame& InFrame )
+	bool ExecuteFunction( int InFuncId, bool InIsNative, FFrame& InFrame )
 	{
 		if ( InIsNative )
 		{
 			assert( !nativeFunctions.empty() && InFuncId >= 0 && InFuncId < nativeFunctions.size() );
 			nativeFunctions[ InFuncId ].functionFn( InFrame );
+			return true;
 		}
 		else
 		{
 			assert( !functions.empty() && InFuncId >= 0 && InFuncId < functions.size() );
-			functions[ InFuncId ].Execute( InFrame );
+			return functions[ InFuncId ].Execute( InFrame );
 		}
 	}
 
-	std::shared_ptr<FScriptVar> GetVarConstant( int InVarId )
+	FFunction& GetFunction( int InFunctionId )
+	{
+		assert( InFunctionId >= 0 && InFunctionId < functions.size() );
+		return functions[ InFunctionId ];
+	}
+
+	const FFunction& GetFunction( int InFunctionId ) const
+	{
+		assert( InFunctionId >= 0 && InFunctionId < functions.size() );
+		return functions[ InFunctionId ];
+	}
+
+	FNativeFunctionFn GetNativeFunctionFn( int InFunctionId ) const
+	{
+		assert( InFunctionId >= 0 && InFunctionId < nativeFunctions.size() );
+		return nativeFunctions[ InFunctionId ].functionFn;
+	}
+
+	const std::string& GetFunctionName( int InFunctionId ) const
+	{
+		assert( InFunctionId >= 0 && InFunctionId < functions.size() );
+		return functions[ InFunctionId ].GetName();
+	}
+
+	const std::string& GetNativeFunctionName( int InFunctionId ) const
+	{
+		assert( InFunctionId >= 0 && InFunctionId < nativeFunctions.size() );
+		return nativeFunctions[ InFunctionId ].name;
+	}
+
+	bool IsNativeFunctionWritingArgs( int InFunctionId ) const
+	{
+		assert( InFunctionId >= 0 && InFunctionId < nativeFunctions.size() );
+		return nativeFunctions[ InFunctionId ].isWritingArgs;
+	}
+
+	const FScriptVar& GetVarConstant( int InVarId ) const
 	{
 		assert( !varConstants.empty() && InVarId >= 0 && InVarId < varConstants.size() );
 		return varConstants[ InVarId ];
 	}
 
 private:
+	// Preflight
+	bool PreflightFunction( int InFuncId, std::vector<bool>& InOutIsInCallChain, FPreflightInfo& OutInfo )
+	{
+		if ( InOutIsInCallChain[ InFuncId ] )
+		{
+			return false;
+		}
+
+		InOutIsInCallChain[ InFuncId ] = true;
+		const FFunction&    function = functions[ InFuncId ];
+		bool                bResult = true;
+		FPreflightInfo      calleesInfo;
+
+		function.ForEachCall( [&]( int InCalleeId, bool InIsNative, int InNumArgs )
+							  {
+								  FPreflightInfo        calleeInfo;
+								  if ( !InIsNative && !PreflightFunction( InCalleeId, InOutIsInCallChain, calleeInfo ) )
+								  {
+									  bResult = false;
+								  }
+
+								  // Constant args written by callee are copied to values below callee frame, args count is upper bound of them
+								  calleesInfo.numValues = std::max( calleesInfo.numValues, InNumArgs + calleeInfo.numValues );
+								  calleesInfo.numArgs = std::max( calleesInfo.numArgs, InNumArgs + calleeInfo.numArgs );
+								  calleesInfo.callDepth = std::max( calleesInfo.callDepth, calleeInfo.callDepth + 1 );
+							  } );
+
+		InOutIsInCallChain[ InFuncId ] = false;
+		OutInfo.numValues = function.GetNumVars() + function.GetNumRegisters() + calleesInfo.numValues;
+		OutInfo.numArgs = function.GetNumOperands() + calleesInfo.numArgs;
+		OutInfo.callDepth = calleesInfo.callDepth;
+		return bResult;
+	}
+
 	// Parse
 	bool Parse( char* str, std::string& OutErrorStr )
 	{
 		// Parse string
 		unsigned int lastID = 0;
+		int firstToken = tokens.size();
 		int left = 0, right = 0;
 		int len = strlen( str );
 
@@ -1205,7 +2896,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = right - startRow + 1;
-					token.originalView = str[ right ];
+					token.view = str + right;
+					token.length = 1;
 					token.type = TT_Operator;
 					token.subType = GetSubtokenInOperator( str[ right ] );
 					lastID++;
@@ -1217,7 +2909,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = right - startRow + 1;
-					token.originalView = str[ right ];
+					token.view = str + right;
+					token.length = 1;
 					token.type = TT_Delimeter;
 					token.subType = GetSubtokenInDelimeter( str[ right ] );
 					lastID++;
@@ -1229,7 +2922,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = right - startRow + 1;
-					token.originalView = str[ right ];
+					token.view = str + right;
+					token.length = 1;
 					token.type = TT_Delimeter;
 					token.subType = GetSubtokenInDelimeter( str[ right ] );
 					++lastID;
@@ -1241,7 +2935,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = right - startRow + 1;
-					token.originalView = str[ right ];
+					token.view = str + right;
+					token.length = 1;
 					token.type = TT_Delimeter;
 					token.subType = GetSubtokenInDelimeter( str[ right ] );
 					lastID++;
@@ -1262,7 +2957,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = left - startRow + 1;
-					token.originalView = subStr;
+					token.view = str + left;
+					token.length = right - left;
 					token.type = TT_Keyword;
 					token.subType = GetSubtokenInKeyword( subStr );
 					++lastID;
@@ -1275,7 +2971,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = left - startRow + 1;
-					token.originalView = subStr;
+					token.view = str + left;
+					token.length = right - left;
 					token.type = TT_Literal;
 					token.subType = STT_Integer;
 					lastID++;
@@ -1288,7 +2985,8 @@ private:
 					token.id = lastID;
 					token.row = row;
 					token.column = left - startRow + 1;
-					token.originalView = subStr;
+					token.view = str + left;
+					token.length = right - left;
 					token.type = TT_Literal;
 					token.subType = STT_Float;
 					++lastID;
@@ -1297,15 +2995,13 @@ private:
 
 				else if ( isConstString( subStr ) == true )
 				{
-					// Remove from subStr '"'
-					subStr[ strlen( subStr ) - 1 ] = '\0';
-					++subStr;
-
+					// Skip '"' of string
 					FToken      token;
 					token.id = lastID;
 					token.row = row;
 					token.column = left - startRow + 1;
-					token.originalView = subStr;
+					token.view = str + left + 1;
+					token.length = right - left - 2;
 					token.type = TT_Literal;
 					token.subType = STT_String;
 					++lastID;
@@ -1318,7 +3014,8 @@ private:
 					FToken      token;
 					token.row = row;
 					token.column = left - startRow + 1;
-					token.originalView = subStr;
+					token.view = str + left;
+					token.length = right - left;
 					token.type = TT_Identifier;
 					token.subType = STT_User;
 
@@ -1337,8 +3034,11 @@ private:
 						  && isDelimiter( str[ right - 1 ] ) == false )
 				{
 					OutErrorStr = std::string( "(" ) + std::to_string( row ) + ":" + std::to_string( left - startRow + 1 ) + "): " + std::string( subStr ) + " is not a valid identifier";
+					free( subStr );
 					return false;
 				}
+
+				free( subStr );
 				left = right;
 			}
 		}
@@ -1348,13 +3048,16 @@ private:
 		// Token Analysis
 		FDeclFunctionSemanticInfo       declFunctionSemanticInfo;
 
-		int     indexToken = 0;
+		int     firstFunction = functions.size();
+		int     firstVarConstant = varConstants.size();
+		int     indexToken = firstToken;
 		while ( indexToken < tokens.size() )
 		{
 			if ( IsDeclFunctionSemantic( indexToken, declFunctionSemanticInfo ) )
 			{
 				std::vector<int>						byteCode;
 				std::unordered_map<std::string, int>    varNameToID;
+				numVirtualRegisters = 0;
 				std::unordered_map<std::string, int>    argsVarNameToID;
 				FAllocateVarCodeSemanticInfo            allocateVarCodeSemanticInfo;
 
@@ -1369,6 +3072,9 @@ private:
 					}
 				}
 
+				// Name is known before body, so function can call itself
+				functionNameToID[ declFunctionSemanticInfo.name ] = functions.size();
+
 				int     indexBodyToken = declFunctionSemanticInfo.startBody;
 				int     lastIndexBodyToken = declFunctionSemanticInfo.startBody + declFunctionSemanticInfo.numBody;
 				if ( !ParseBody( indexBodyToken, lastIndexBodyToken, varNameToID, argsVarNameToID, byteCode ) )
@@ -1377,7 +3083,8 @@ private:
 					return false;
 				}
 
-				RegisterFunction( FFunction( declFunctionSemanticInfo.name, byteCode ) );
+				byteCode.push_back( Op_Return );
+				RegisterFunction( FFunction( declFunctionSemanticInfo.name, byteCode, varNameToID.size(), numVirtualRegisters ) );
 			}
 			else
 			{
@@ -1385,6 +3092,32 @@ private:
 			}
 		}
 
+		CompactVarConstants( firstFunction, firstVarConstant );
+
+		// Functions of module may call each other, so written args are marked until nothing changes
+		bool    isWrittenArgsChanged = true;
+		while ( isWrittenArgsChanged )
+		{
+			isWrittenArgsChanged = false;
+			for ( int i = firstFunction; i < functions.size(); ++i )
+			{
+				isWrittenArgsChanged |= functions[ i ].UpdateWrittenArgs( *this );
+			}
+		}
+
+		for ( int i = firstFunction; i < functions.size(); ++i )
+		{
+			functions[ i ].SpecializeTypes( *this );
+			functions[ i ].FuseOperations();
+			functions[ i ].OptimizeJumps();
+			functions[ i ].AllocateRegisters();
+			functions[ i ].EliminateTailCalls();
+			if ( !functions[ i ].Link( *this ) )
+			{
+				printf( "Error: function '%s' is too large for byte code\n", functions[ i ].GetName().c_str() );
+				return false;
+			}
+		}
 		return true;
 	}
 
@@ -1411,37 +3144,21 @@ private:
 				{
 					const FToken& token = tokens[ indexArgToken ];
 					int                 varId = 0;
-					std::shared_ptr<FScriptVar>          scriptVar = std::make_shared<FScriptVar>();
 
 					if ( token.type == TT_Literal )
 					{
-						switch ( token.subType )
+						if ( !RegisterVarConstant( token, &varId ) )
 						{
-						case STT_String:
-							scriptVar->SetString( token.originalView );
-							break;
-
-						case STT_Integer:
-							scriptVar->SetInt( atoi( token.originalView.c_str() ) );
-							break;
-
-						case STT_Bool:
-							scriptVar->SetBool( atoi( token.originalView.c_str() ) );
-							break;
-
-						default:
 							assert( false );
 							return false;
-							break;
 						}
 
-						RegisterVarConstant( scriptVar, &varId );
 						OutByteCode.push_back( SVF_Const );
 						OutByteCode.push_back( varId );
 					}
 					else if ( token.type == TT_Identifier && token.subType == STT_User )
 					{
-						auto    itArgVar = InArgVarsNameToID.find( token.originalView );
+						auto    itArgVar = InArgVarsNameToID.find( token.GetOriginalView() );
 						if ( itArgVar != InArgVarsNameToID.end() )
 						{
 							OutByteCode.push_back( SVF_Arg );
@@ -1449,7 +3166,7 @@ private:
 							continue;
 						}
 
-						auto    itVar = InVarsNameToID.find( token.originalView );
+						auto    itVar = InVarsNameToID.find( token.GetOriginalView() );
 						if ( itVar != InVarsNameToID.end() )
 						{
 							OutByteCode.push_back( SVF_User );
@@ -1467,13 +3184,23 @@ private:
 					}
 				}
 			}
+			else if ( IsReturnCodeSemantic( tmpIndexBodyToke, numTokens ) )
+			{
+				OutByteCode.push_back( Op_Return );
+			}
 			else if ( IsAllocateVarCodeSemantic( tmpIndexBodyToke, numTokens, allocateVarCodeSemanticInfo ) )
 			{
+				// Each variable name gets one slot in frame, a re-declaration (e.g. inside a loop) resets it
+				auto    itVar = InVarsNameToID.find( allocateVarCodeSemanticInfo.name );
+				if ( itVar == InVarsNameToID.end() )
+				{
+					int     numVars = InVarsNameToID.size();
+					itVar = InVarsNameToID.insert( std::make_pair( allocateVarCodeSemanticInfo.name, numVars ) ).first;
+				}
+
 				OutByteCode.push_back( Op_AllocateVar );
 				OutByteCode.push_back( allocateVarCodeSemanticInfo.varType );
-
-				int     numVars = InVarsNameToID.size();
-				InVarsNameToID[ allocateVarCodeSemanticInfo.name ] = numVars;
+				OutByteCode.push_back( itVar->second );
 			}
 			else if ( IsAssignCodeSemantic( tmpIndexBodyToke, numTokens, InVarsNameToID, InArgVarsNameToID, assignCodeSemanticInfo ) )
 			{
@@ -1996,15 +3723,28 @@ private:
 					}
 				}
 
-				OutByteCode.push_back( Op_Add );
-				OutByteCode.push_back( arithmeticCodeSemanticInfo.leftVarId );
-				OutByteCode.push_back( varFlag );
-				OutByteCode.push_back( arithmeticCodeSemanticInfo.rightVarId );
-
-				OutByteCode.push_back( Op_Assign );
-				OutByteCode.push_back( arithmeticCodeSemanticInfo.resultToVarId );
-				OutByteCode.push_back( SVF_Register );
-				OutByteCode.push_back( SR_AX );
+				// a = a + b is done in place, without temporary result
+				if ( arithmeticCodeSemanticInfo.resultToVarId == arithmeticCodeSemanticInfo.leftVarId )
+				{
+					OutByteCode.push_back( Op_AddAssign );
+					OutByteCode.push_back( arithmeticCodeSemanticInfo.leftVarId );
+					OutByteCode.push_back( varFlag );
+					OutByteCode.push_back( arithmeticCodeSemanticInfo.rightVarId );
+				}
+				else
+				{
+					int     resultRegister = numVirtualRegisters++;
+					OutByteCode.push_back( Op_Add );
+					OutByteCode.push_back( resultRegister );
+					OutByteCode.push_back( arithmeticCodeSemanticInfo.leftVarId );
+					OutByteCode.push_back( varFlag );
+					OutByteCode.push_back( arithmeticCodeSemanticInfo.rightVarId );
+
+					OutByteCode.push_back( Op_Assign );
+					OutByteCode.push_back( arithmeticCodeSemanticInfo.resultToVarId );
+					OutByteCode.push_back( SVF_Register );
+					OutByteCode.push_back( resultRegister );
+				}
 			}
 			else if ( IsSubstructCodeSemantic( tmpIndexBodyToke, numTokens, InVarsNameToID, InArgVarsNameToID, arithmeticCodeSemanticInfo ) )
 			{
@@ -2021,7 +3761,9 @@ private:
 					}
 				}
 
+				int     resultRegister = numVirtualRegisters++;
 				OutByteCode.push_back( Op_Substruct );
+				OutByteCode.push_back( resultRegister );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.leftVarId );
 				OutByteCode.push_back( varFlag );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.rightVarId );
@@ -2029,7 +3771,7 @@ private:
 				OutByteCode.push_back( Op_Assign );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.resultToVarId );
 				OutByteCode.push_back( SVF_Register );
-				OutByteCode.push_back( SR_AX );
+				OutByteCode.push_back( resultRegister );
 			}
 			else if ( IsMultiplyCodeSemantic( tmpIndexBodyToke, numTokens, InVarsNameToID, InArgVarsNameToID, arithmeticCodeSemanticInfo ) )
 			{
@@ -2046,7 +3788,9 @@ private:
 					}
 				}
 
+				int     resultRegister = numVirtualRegisters++;
 				OutByteCode.push_back( Op_Multiply );
+				OutByteCode.push_back( resultRegister );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.leftVarId );
 				OutByteCode.push_back( varFlag );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.rightVarId );
@@ -2054,7 +3798,7 @@ private:
 				OutByteCode.push_back( Op_Assign );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.resultToVarId );
 				OutByteCode.push_back( SVF_Register );
-				OutByteCode.push_back( SR_AX );
+				OutByteCode.push_back( resultRegister );
 			}
 			else if ( IsDivideCodeSemantic( tmpIndexBodyToke, numTokens, InVarsNameToID, InArgVarsNameToID, arithmeticCodeSemanticInfo ) )
 			{
@@ -2071,7 +3815,9 @@ private:
 					}
 				}
 
+				int     resultRegister = numVirtualRegisters++;
 				OutByteCode.push_back( Op_Divide );
+				OutByteCode.push_back( resultRegister );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.leftVarId );
 				OutByteCode.push_back( varFlag );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.rightVarId );
@@ -2079,7 +3825,7 @@ private:
 				OutByteCode.push_back( Op_Assign );
 				OutByteCode.push_back( arithmeticCodeSemanticInfo.resultToVarId );
 				OutByteCode.push_back( SVF_Register );
-				OutByteCode.push_back( SR_AX );
+				OutByteCode.push_back( resultRegister );
 			}
 			else
 			{
@@ -2159,6 +3905,7 @@ private:
 			bool                                    isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutArithmeticCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -2170,7 +3917,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( isAref )
@@ -2193,7 +3940,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( isAref )
@@ -2244,26 +3991,7 @@ private:
 					else if ( semanticItem.type == TT_Literal )
 					{
 						OutArithmeticCodeSemanticInfo.isRightConstVar = true;
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutArithmeticCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], &OutArithmeticCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -2338,6 +4066,7 @@ private:
 			bool                                    isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutArithmeticCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -2349,7 +4078,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( isAref )
@@ -2372,7 +4101,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( isAref )
@@ -2423,26 +4152,7 @@ private:
 					else if ( semanticItem.type == TT_Literal )
 					{
 						OutArithmeticCodeSemanticInfo.isRightConstVar = true;
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutArithmeticCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], &OutArithmeticCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -2517,6 +4227,7 @@ private:
 			bool                                    isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutArithmeticCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -2528,7 +4239,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( isAref )
@@ -2551,7 +4262,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( isAref )
@@ -2602,26 +4313,7 @@ private:
 					else if ( semanticItem.type == TT_Literal )
 					{
 						OutArithmeticCodeSemanticInfo.isRightConstVar = true;
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutArithmeticCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], &OutArithmeticCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -2696,6 +4388,7 @@ private:
 			bool                                    isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutArithmeticCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -2707,7 +4400,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( isAref )
@@ -2730,7 +4423,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( isAref )
@@ -2781,26 +4474,7 @@ private:
 					else if ( semanticItem.type == TT_Literal )
 					{
 						OutArithmeticCodeSemanticInfo.isRightConstVar = true;
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutArithmeticCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], &OutArithmeticCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -2861,6 +4535,8 @@ private:
 			bool         isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutCompareCodeSemanticInfo.isLeftConstVar = false;
+			OutCompareCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -2872,7 +4548,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -2888,7 +4564,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -2916,7 +4592,8 @@ private:
 					}
 					else if ( semanticItem.type == TT_Literal )
 					{
-						if ( !isRightVar )
+						bool    isLeftConst = !isRightVar;
+						if ( isLeftConst )
 						{
 							OutCompareCodeSemanticInfo.isLeftConstVar = true;
 						}
@@ -2927,26 +4604,7 @@ private:
 
 						isRightVar = !isRightVar;
 
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutCompareCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], isLeftConst ? &OutCompareCodeSemanticInfo.leftVarId : &OutCompareCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -3007,6 +4665,8 @@ private:
 			int         numAppropriate = 0;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutCompareCodeSemanticInfo.isLeftConstVar = false;
+			OutCompareCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -3018,7 +4678,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -3034,7 +4694,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -3066,7 +4726,8 @@ private:
 					}
 					else if ( semanticItem.type == TT_Literal )
 					{
-						if ( !isRightVar )
+						bool    isLeftConst = !isRightVar;
+						if ( isLeftConst )
 						{
 							OutCompareCodeSemanticInfo.isLeftConstVar = true;
 						}
@@ -3075,26 +4736,7 @@ private:
 							OutCompareCodeSemanticInfo.isRightConstVar = true;
 						}
 
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutCompareCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], isLeftConst ? &OutCompareCodeSemanticInfo.leftVarId : &OutCompareCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -3151,6 +4793,8 @@ private:
 			bool         isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutCompareCodeSemanticInfo.isLeftConstVar = false;
+			OutCompareCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -3162,7 +4806,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -3178,7 +4822,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -3206,7 +4850,8 @@ private:
 					}
 					else if ( semanticItem.type == TT_Literal )
 					{
-						if ( !isRightVar )
+						bool    isLeftConst = !isRightVar;
+						if ( isLeftConst )
 						{
 							OutCompareCodeSemanticInfo.isLeftConstVar = true;
 						}
@@ -3217,26 +4862,7 @@ private:
 
 						isRightVar = !isRightVar;
 
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutCompareCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], isLeftConst ? &OutCompareCodeSemanticInfo.leftVarId : &OutCompareCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -3293,6 +4919,8 @@ private:
 			bool         isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutCompareCodeSemanticInfo.isLeftConstVar = false;
+			OutCompareCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -3304,7 +4932,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -3320,7 +4948,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -3348,7 +4976,8 @@ private:
 					}
 					else if ( semanticItem.type == TT_Literal )
 					{
-						if ( !isRightVar )
+						bool    isLeftConst = !isRightVar;
+						if ( isLeftConst )
 						{
 							OutCompareCodeSemanticInfo.isLeftConstVar = true;
 						}
@@ -3359,26 +4988,7 @@ private:
 
 						isRightVar = !isRightVar;
 
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutCompareCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], isLeftConst ? &OutCompareCodeSemanticInfo.leftVarId : &OutCompareCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -3438,6 +5048,8 @@ private:
 			bool         isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutCompareCodeSemanticInfo.isLeftConstVar = false;
+			OutCompareCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -3449,7 +5061,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -3465,7 +5077,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -3493,7 +5105,8 @@ private:
 					}
 					else if ( semanticItem.type == TT_Literal )
 					{
-						if ( !isRightVar )
+						bool    isLeftConst = !isRightVar;
+						if ( isLeftConst )
 						{
 							OutCompareCodeSemanticInfo.isLeftConstVar = true;
 						}
@@ -3504,26 +5117,7 @@ private:
 
 						isRightVar = !isRightVar;
 
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutCompareCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], isLeftConst ? &OutCompareCodeSemanticInfo.leftVarId : &OutCompareCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -3583,6 +5177,8 @@ private:
 			bool         isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutCompareCodeSemanticInfo.isLeftConstVar = false;
+			OutCompareCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -3594,7 +5190,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -3610,7 +5206,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -3638,7 +5234,8 @@ private:
 					}
 					else if ( semanticItem.type == TT_Literal )
 					{
-						if ( !isRightVar )
+						bool    isLeftConst = !isRightVar;
+						if ( isLeftConst )
 						{
 							OutCompareCodeSemanticInfo.isLeftConstVar = true;
 						}
@@ -3649,26 +5246,7 @@ private:
 
 						isRightVar = !isRightVar;
 
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutCompareCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], isLeftConst ? &OutCompareCodeSemanticInfo.leftVarId : &OutCompareCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -3846,6 +5424,9 @@ private:
 						case STT_Else:
 							isIfBlock = false;
 							break;
+
+						default:
+							break;
 						}
 					}
 				}
@@ -3925,6 +5506,7 @@ private:
 			bool                                    isRightVar = false;
 			const std::vector<FSemanticItem>& semantic = semantics[ indexSemantics ];
 			result = true;
+			OutAssignCodeSemanticInfo.isRightConstVar = false;
 
 			currentToken = startToken;
 			for ( int indexSemantic = 0; currentToken <= endToken && indexSemantic < semantic.size(); ++currentToken )
@@ -3936,7 +5518,7 @@ private:
 					{
 						bool    isSeccussed = false;
 						{
-							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].originalView );
+							auto    itArgVarId = InArgVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 							if ( itArgVarId != InArgVarsNameToID.end() )
 							{
 								if ( !isRightVar )
@@ -3952,7 +5534,7 @@ private:
 							}
 							else
 							{
-								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].originalView );
+								auto    itVarId = InVarsNameToID.find( tokens[ currentToken ].GetOriginalView() );
 								if ( itVarId != InVarsNameToID.end() )
 								{
 									if ( !isRightVar )
@@ -3983,26 +5565,7 @@ private:
 					else if ( semanticItem.type == TT_Literal )
 					{
 						OutAssignCodeSemanticInfo.isRightConstVar = true;
-						EScriptVarType      varType = SubtokenTypeToScriptVarType( tokens[ currentToken ].subType );
-						assert( varType != SVT_None );
-
-						std::shared_ptr<FScriptVar>   scriptVar = std::make_shared<FScriptVar>();
-						switch ( varType )
-						{
-						case SVT_String:
-							scriptVar->SetString( tokens[ currentToken ].originalView );
-							break;
-
-						case SVT_Int:
-							scriptVar->SetInt( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-
-						case SVT_Bool:
-							scriptVar->SetBool( atoi( tokens[ currentToken ].originalView.c_str() ) );
-							break;
-						}
-
-						RegisterVarConstant( scriptVar, &OutAssignCodeSemanticInfo.rightVarId );
+						RegisterVarConstant( tokens[ currentToken ], &OutAssignCodeSemanticInfo.rightVarId );
 					}
 
 					++indexSemantic;
@@ -4046,7 +5609,7 @@ private:
 			{
 				if ( semanticItem.type == TT_Identifier && semanticItem.subType == STT_User )
 				{
-					OutAllocateVarCodeSemanticInfo.name = tokens[ InOutTokenIndex ].originalView;
+					OutAllocateVarCodeSemanticInfo.name = tokens[ InOutTokenIndex ].GetOriginalView();
 				}
 				else if ( semanticItem.type == TT_Keyword )
 				{
@@ -4065,6 +5628,32 @@ private:
 		return true;
 	}
 
+	bool IsReturnCodeSemantic( int& InOutTokenIndex, int InNumTokens )
+	{
+		static std::vector<FSemanticItem>       semantics =
+		{
+			FSemanticItem( TT_Keyword, STT_Return ),
+			FSemanticItem( TT_Delimeter, STT_EndCodeLine )
+		};
+
+		if ( tokens.size() - InOutTokenIndex < semantics.size() || InNumTokens < semantics.size() )
+		{
+			return false;
+		}
+
+		int     oldToken = InOutTokenIndex;
+		for ( int index = 0; index < semantics.size(); ++index, ++InOutTokenIndex )
+		{
+			if ( !semantics[ index ].Match( tokens[ InOutTokenIndex ] ) )
+			{
+				InOutTokenIndex = oldToken;
+				return false;
+			}
+		}
+
+		return true;
+	}
+
 	bool IsAllocateVarCodeSemantic( int& InOutTokenIndex, int InNumTokens, FAllocateVarCodeSemanticInfo& OutAllocateVarCodeSemanticInfo )
 	{
 		static std::vector<FSemanticItem>       semantics =
@@ -4088,7 +5677,7 @@ private:
 			{
 				if ( semanticItem.type == TT_Identifier && semanticItem.subType == STT_User )
 				{
-					OutAllocateVarCodeSemanticInfo.name = tokens[ InOutTokenIndex ].originalView;
+					OutAllocateVarCodeSemanticInfo.name = tokens[ InOutTokenIndex ].GetOriginalView();
 				}
 				else if ( semanticItem.type == TT_Keyword )
 				{
@@ -4137,7 +5726,7 @@ private:
 				{
 					int     funcId;
 					bool    isNative = false;
-					if ( !GetFunctionInfoByName( tokens[ InOutTokenIndex ].originalView, funcId, isNative ) )
+					if ( !GetFunctionInfoByName( tokens[ InOutTokenIndex ].GetOriginalView(), funcId, isNative ) )
 					{
 						return false;
 					}
@@ -4202,7 +5791,7 @@ private:
 				{
 					if ( semanticItem.type == TT_Identifier && semanticItem.subType == STT_User )
 					{
-						OutDeclFunctionSemanticInfo.name = tokens[ InOutTokenIndex ].originalView;
+						OutDeclFunctionSemanticInfo.name = tokens[ InOutTokenIndex ].GetOriginalView();
 					}
 					else if ( semanticItem.subType == STT_BeginArgs )
 					{
@@ -4261,20 +5850,106 @@ private:
 		functionNameToID[ InFunction.GetName() ] = functionId;
 	}
 
-	void RegisterNativeFunction( const std::string& InFuncName, FNativeFunctionFn InFn )
+	void RegisterVarConstant( const FScriptVar& InVar, int* InVarId = nullptr )
 	{
-		int     nativeFunctionId = nativeFunctions.size();
-		nativeFunctions.push_back( FNativeFunction{ InFuncName, InFn } );
-		nativeFunctionNameToID[ InFuncName ] = nativeFunctionId;
+		// Equal constants share one entry in pool
+		int     varId;
+		auto    itVar = varConstantToID.find( InVar );
+		if ( itVar != varConstantToID.end() )
+		{
+			varId = itVar->second;
+		}
+		else
+		{
+			varId = varConstants.size();
+			varConstants.push_back( InVar );
+			varConstantToID[ InVar ] = varId;
+		}
+
+		if ( InVarId )
+		{
+			*InVarId = varId;
+		}
 	}
 
-	void RegisterVarConstant( std::shared_ptr<FScriptVar>& InVar, int* InVarId = nullptr )
+	bool RegisterVarConstant( const FToken& InToken, int* InVarId = nullptr )
 	{
-		if ( InVarId )
+		FScriptVar      scriptVar;
+		switch ( InToken.subType )
+		{
+		case STT_String:
+			scriptVar.SetInternedString( stringTable.Intern( InToken.GetOriginalView() ) );
+			break;
+
+		case STT_Integer:
+			scriptVar.SetInt( atoll( InToken.GetOriginalView().c_str() ) );
+			break;
+
+		case STT_Bool:
+			scriptVar.SetBool( atoi( InToken.GetOriginalView().c_str() ) );
+			break;
+
+		case STT_Float:
+			scriptVar.SetDouble( atof( InToken.GetOriginalView().c_str() ) );
+			break;
+
+		default:
+			return false;
+		}
+
+		RegisterVarConstant( scriptVar, InVarId );
+		return true;
+	}
+
+	// Remove constants of new module which not used in byte code (left by abandoned semantic matches)
+	void CompactVarConstants( int InFirstFunction, int InFirstVarConstant )
+	{
+		std::vector<int>        newVarIds( varConstants.size() - InFirstVarConstant, -1 );
+		for ( int i = InFirstFunction; i < functions.size(); ++i )
+		{
+			functions[ i ].ForEachVarOperand( [&]( int InVarFlag, int& InOutVarId )
+											   {
+												   if ( InVarFlag == SVF_Const && InOutVarId >= InFirstVarConstant )
+												   {
+													   newVarIds[ InOutVarId - InFirstVarConstant ] = 0;
+												   }
+											   } );
+		}
+
+		int     numVarConstants = InFirstVarConstant;
+		for ( int i = 0; i < newVarIds.size(); ++i )
+		{
+			if ( newVarIds[ i ] == -1 )
+			{
+				continue;
+			}
+
+			newVarIds[ i ] = numVarConstants;
+			if ( numVarConstants != InFirstVarConstant + i )
+			{
+				varConstants[ numVarConstants ] = varConstants[ InFirstVarConstant + i ];
+			}
+			++numVarConstants;
+		}
+		varConstants.resize( numVarConstants );
+		varConstants.shrink_to_fit();
+
+		for ( int i = InFirstFunction; i < functions.size(); ++i )
+		{
+			functions[ i ].ForEachVarOperand( [&]( int InVarFlag, int& InOutVarId )
+											   {
+												   if ( InVarFlag == SVF_Const && InOutVarId >= InFirstVarConstant )
+												   {
+													   InOutVarId = newVarIds[ InOutVarId - InFirstVarConstant ];
+												   }
+											   } );
+		}
+
+		varConstantToID.clear();
+		for ( int i = 0; i < varConstants.size(); ++i )
 		{
-			*InVarId = varConstants.size();
+			varConstantToID[ varConstants[ i ] ] = i;
 		}
-		varConstants.push_back( InVar );
 	}
 
 	bool GetFunctionInfoByName( const std::string& InFuncName, int& InFuncId, bool& InIsNativeFunc )
@@ -4298,588 +5973,2222 @@ private:
 		return false;
 	}
 
-	std::vector< FToken >                                                                            tokens;             // Array of tokens
+	std::deque<std::string>                       sourceCodes;              // Source codes of loaded scripts
+	int                                           numVirtualRegisters;      // Virtual registers allocated for temporary results in compiled function
+	FTokenStream                                  tokens;                   // Array of tokens
 	std::unordered_map< FToken, unsigned int, FToken::FTokenKeyFunc, FToken::FTokenEqualFunc >       userIdentifiers;    // User identifiers map
 
 	std::unordered_map<std::string, int>          functionNameToID;         // Function name to id
 	std::unordered_map<std::string, int>          nativeFunctionNameToID;   // Native function name to id
-	std::vector<FFunction>                        functions;                // Functions
+	std::deque<FFunction>                         functions;                // Functions, deque keeps their addresses for linked calls
 	std::vector<FNativeFunction>                  nativeFunctions;          // Native functions
-	std::vector<std::shared_ptr<FScriptVar>>      varConstants;             // Var constants
+	std::vector<FScriptVar>                       varConstants;             // Var constants
+	std::unordered_map<FScriptVar, int, FScriptVar::FHashFunc, FScriptVar::FEqualFunc>      varConstantToID;      // Var constant to id
+	FStringTable                                  stringTable;              // Interned string constants
 };
 
 /** C translator */
 FCTranslator        GCTranslator;
 
-void FFunction::Execute( FFrame& InFrame )
+bool FFunction::Link( FCTranslator& InTranslator )
 {
-	bool        isCompareResult = false;
+	std::unordered_map<int64_t, int>        operandToIndex;
+	std::vector<int>                        resolvedCode = code;
+	operandSources.clear();
+	constants.clear();
+	callTargets.clear();
+
+	// Constants take first indices of operand table, so interpreter tells constant args of calls by index
+	for ( int pass = 0; pass < 2; ++pass )
+	{
+		ForEachVarOperand( resolvedCode, [&]( int InVarFlag, int& InOutVarId )
+										{
+											if ( pass == 0 && InVarFlag != SVF_Const )
+											{
+												return;
+											}
+
+											int64_t     key = ( int64_t( InVarFlag ) << 32 ) | uint32_t( InOutVarId );
+											auto        itOperand = operandToIndex.find( key );
+											if ( itOperand == operandToIndex.end() )
+											{
+												itOperand = operandToIndex.insert( std::make_pair( key, ( int ) operandSources.size() ) ).first;
+												if ( InVarFlag == SVF_Const )
+												{
+													operandSources.push_back( FOperandSource{ SVF_Const, ( int ) constants.size() } );
+													constants.push_back( InTranslator.GetVarConstant( InOutVarId ) );
+												}
+												else
+												{
+													operandSources.push_back( FOperandSource{ InVarFlag, InOutVarId } );
+												}
+											}
+
+											if ( pass == 1 )
+											{
+												InOutVarId = itOperand->second;
+											}
+										} );
+	}
 
-	std::shared_ptr<FScriptVar>		registers[ SR_Num ] =
+	// Jump targets become offsets in packed byte code
+	std::vector<int>        offsets( resolvedCode.size() + 1, 0 );
+	int                     offset = 0;
+	for ( int i = 0; i < resolvedCode.size(); i += GetOperationSize( &resolvedCode[ i ] ) )
 	{
-		std::make_shared<FScriptVar>()
-	};
+		int     numArgs = GetOperationFormat( resolvedCode[ i ] ) == OF_Call ? resolvedCode[ i + 2 ] : 0;
+		offsets[ i ] = offset;
+		offset += 1 + GetNumPackedOperands( resolvedCode[ i ], numArgs ) * sizeof( FPackedOperand );
+	}
+	offsets[ resolvedCode.size() ] = offset;
 
-	for ( int i = 0; i < code.size(); )
+	std::vector<int>        operands;
+	linkedCode.clear();
+	linkedCode.reserve( offset );
+	for ( int i = 0; i < resolvedCode.size(); i += GetOperationSize( &resolvedCode[ i ] ) )
 	{
-		EScriptOperation        op = ( EScriptOperation ) code[ i ];
-		switch ( op )
+		const int*      operation = &resolvedCode[ i ];
+		operands.clear();
+		switch ( GetOperationFormat( operation[ 0 ] ) )
 		{
-		case Op_Call:
+		case OF_Call:
 		{
-			int              functionId = code[ i + 1 ];
-			int              numArgs = code[ i + 2 ];
-			FFrame           callFrame;
+			// Call sites of one callee share entry of call table
+			bool        isNative = operation[ 0 ] == Op_NativeCall;
+			int         callTarget = 0;
+			while ( callTarget < callTargets.size() && ( callTargets[ callTarget ].functionId != operation[ 1 ] || ( callTargets[ callTarget ].nativeFunctionFn != nullptr ) != isNative ) )
+			{
+				++callTarget;
+			}
 
-			for ( int j = 0; j < numArgs; ++j )
+			if ( callTarget == callTargets.size() )
 			{
-				int     varFlag = code[ i + 3 + j * 2 ];
-				int     varId = code[ i + 4 + j * 2 ];
+				callTargets.push_back( FCallTarget{ operation[ 1 ], isNative ? nullptr : &InTranslator.GetFunction( operation[ 1 ] ), isNative ? InTranslator.GetNativeFunctionFn( operation[ 1 ] ) : nullptr, isNative && InTranslator.IsNativeFunctionWritingArgs( operation[ 1 ] ) } );
+			}
 
-				switch ( varFlag )
-				{
-				case SVF_User:
-					callFrame.args.push_back( InFrame.vars[ varId ] );
-					break;
+			operands.push_back( callTarget );
+			operands.push_back( operation[ 2 ] );
+			for ( int j = 0; j < operation[ 2 ]; ++j )
+			{
+				operands.push_back( operation[ 4 + j * 2 ] );
+			}
+			break;
+		}
 
-				case SVF_Const:
-					callFrame.args.push_back( GCTranslator.GetVarConstant( varId ) );
-					break;
+		case OF_AllocateVar:
+			operands.push_back( operation[ 1 ] );
+			operands.push_back( operation[ 2 ] );
+			break;
 
-				case SVF_Arg:
-					callFrame.args.push_back( InFrame.args[ varId ] );
-					break;
-				}
-			}
+		case OF_Binary:
+			operands.push_back( operation[ 1 ] );
+			operands.push_back( operation[ 3 ] );
+			break;
+
+		case OF_Arithmetic:
+		case OF_Ternary:
+			operands.push_back( operation[ 1 ] );
+			operands.push_back( operation[ 2 ] );
+			operands.push_back( operation[ 4 ] );
+			break;
+
+		case OF_Compare:
+			operands.push_back( operation[ 2 ] );
+			operands.push_back( operation[ 4 ] );
+			break;
+
+		case OF_Branch:
+			operands.push_back( operation[ 2 ] );
+			operands.push_back( operation[ 4 ] );
+			operands.push_back( offsets[ operation[ 5 ] ] );
+			break;
 
-			GCTranslator.ExecuteFunction( functionId, false, callFrame );
+		case OF_Jump:
+			operands.push_back( offsets[ operation[ 1 ] ] );
+			break;
 
-			i += 3 + ( numArgs * 2 );
+		default:
 			break;
 		}
 
-		case Op_NativeCall:
+		if ( !EncodeOperation( operation[ 0 ], operands, linkedCode ) )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FFunction::UpdateWrittenArgs( const FCTranslator& InTranslator )
+{
+	bool    isChanged = false;
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		if ( GetOperationFormat( code[ i ] ) != OF_Call )
 		{
-			int              codeOffset = 1;
-			int              functionId = code[ i + codeOffset ];
-			++codeOffset;
-			int              numArgs = code[ i + codeOffset ];
-			FFrame           callFrame;
+			continue;
+		}
 
-			if ( numArgs > 0 )
+		bool    isNative = code[ i ] == Op_NativeCall;
+		int     calleeId = code[ i + 1 ];
+		for ( int j = 0; j < code[ i + 2 ]; ++j )
+		{
+			int     varFlag = code[ i + 3 + j * 2 ];
+			int     varId = code[ i + 4 + j * 2 ];
+			if ( varFlag != SVF_Arg || IsArgWritten( varId ) )
 			{
-				++codeOffset;
+				continue;
 			}
 
-			for ( int j = 0; j < numArgs; ++j )
+			if ( isNative ? InTranslator.IsNativeFunctionWritingArgs( calleeId ) : InTranslator.GetFunction( calleeId ).IsArgWritten( j ) )
 			{
-				int     varFlag = code[ i + codeOffset ];
-				int     varId = code[ i + codeOffset + 1 ];
-
-				switch ( varFlag )
+				if ( varId >= writtenArgs.size() )
 				{
-				case SVF_User:
-					callFrame.args.push_back( InFrame.vars[ varId ] );
-					break;
-
-				case SVF_Const:
-					callFrame.args.push_back( GCTranslator.GetVarConstant( varId ) );
-					break;
-
-				case SVF_Arg:
-					callFrame.args.push_back( InFrame.args[ varId ] );
-					break;
+					writtenArgs.resize( varId + 1, false );
 				}
 
-				codeOffset += 2;
+				writtenArgs[ varId ] = true;
+				isChanged = true;
 			}
-
-			GCTranslator.ExecuteFunction( functionId, true, callFrame );
-			i += codeOffset;
-			break;
 		}
+	}
+	return isChanged;
+}
 
-		case  Op_AllocateVar:
-		{
-			std::shared_ptr<FScriptVar>      scriptVar = std::make_shared<FScriptVar>();
-			EScriptVarType  varType = ( EScriptVarType ) code[ i + 1 ];
+bool FFunction::EnterFrame( FFrame& InFrame )
+{
+	// Allocate slots for all local variables and registers once
+	InFrame.vars = InFrame.stack->PushValues( numVars + numRegisters );
+	if ( !InFrame.vars )
+	{
+		printf( "Error: stack overflow in function '%s'\n", name.c_str() );
+		return false;
+	}
 
-			switch ( varType )
-			{
-			case SVT_Int:
-				scriptVar->SetInt( 0 );
-				break;
+	// Resolve operands of linked byte code for this frame
+	InFrame.operands = InFrame.stack->PushOperands( operandSources.size() );
+	if ( !InFrame.operands )
+	{
+		InFrame.stack->PopValues( numVars + numRegisters );
+		printf( "Error: stack overflow in function '%s'\n", name.c_str() );
+		return false;
+	}
 
-			case SVT_String:
-				scriptVar->SetString( "" );
-				break;
+	for ( int i = 0; i < operandSources.size(); ++i )
+	{
+		const FOperandSource&   operandSource = operandSources[ i ];
+		switch ( operandSource.varFlag )
+		{
+		case SVF_User:
+			InFrame.operands[ i ] = &InFrame.vars[ operandSource.varId ];
+			break;
 
-			case SVT_Bool:
-				scriptVar->SetBool( false );
-				break;
-			}
+		case SVF_Const:
+			InFrame.operands[ i ] = &constants[ operandSource.varId ];
+			break;
 
-			InFrame.vars.push_back( scriptVar );
+		case SVF_Arg:
+			InFrame.operands[ i ] = InFrame.args[ operandSource.varId ];
+			break;
 
-			i += 2;
+		case SVF_Register:
+			InFrame.operands[ i ] = &InFrame.vars[ numVars + operandSource.varId ];
 			break;
 		}
+	}
+	return true;
+}
 
-		case Op_Assign:
-		{
-			int         leftVarId = code[ i + 1 ];
-			int         rightVarFlag = code[ i + 2 ];
-			int         rightVarId = code[ i + 3 ];
-
-			switch ( rightVarFlag )
-			{
-			case SVF_User:
-				InFrame.vars[ leftVarId ]->Set( InFrame.vars[ rightVarId ] );
-				break;
+void FFunction::LeaveFrame( FFrame& InFrame )
+{
+	InFrame.stack->PopOperands( operandSources.size() );
+	InFrame.stack->PopValues( numVars + numRegisters );
+}
 
-			case SVF_Const:
-				InFrame.vars[ leftVarId ]->Set( GCTranslator.GetVarConstant( rightVarId ) );
-				break;
+bool FFunction::Execute( FFrame& InFrame )
+{
+	if ( !EnterFrame( InFrame ) )
+	{
+		return false;
+	}
 
-			case SVF_Arg:
-				InFrame.vars[ leftVarId ]->Set( InFrame.args[ rightVarId ] );
-				break;
+	int         numCalls = InFrame.stack->GetNumCalls();
+#if SCRIPT_THREADED_DISPATCH
+	bool        bResult = GIsThreadedDispatch ? ExecuteCode<true>( InFrame ) : ExecuteCode<false>( InFrame );
+#else
+	bool        bResult = ExecuteCode<false>( InFrame );
+#endif // SCRIPT_THREADED_DISPATCH
 
-			case SVF_Register:
-				InFrame.vars[ leftVarId ]->Set( registers[ rightVarId ] );
-				break;
+	// Interpreter stops on error with frames of nested calls on stack
+	while ( InFrame.stack->GetNumCalls() > numCalls )
+	{
+		FCallRecord&    call = InFrame.stack->GetTopCall();
+		call.function->LeaveFrame( call.frame );
+		InFrame.stack->PopArgs( call.frame.numArgs );
+		InFrame.stack->PopArgValues( call.numArgValues );
+		InFrame.stack->PopCall();
+	}
 
-			default:
-				assert( false );
-				break;
-			}
+	LeaveFrame( InFrame );
+	return bResult;
+}
 
-			i += 4;
-			break;
+// Specialized operation of InOperation for operands of InVarType, or InOperation if there is none
+static int GetSpecializedOperation( int InOperation, int InVarType )
+{
+	switch ( InVarType )
+	{
+	case SVT_Int:
+		switch ( InOperation )
+		{
+		case Op_Assign:         return Op_AssignInt;
+		case Op_Add:            return Op_AddInt;
+		case Op_Substruct:      return Op_SubstructInt;
+		case Op_Multiply:       return Op_MultiplyInt;
+		case Op_Divide:         return Op_DivideInt;
+		case Op_AddAssign:      return Op_AddAssignInt;
+		case Op_Compare:        return Op_CompareInt;
+		case Op_NotCompare:     return Op_NotCompareInt;
+		case Op_More:           return Op_MoreInt;
+		case Op_MoreThen:       return Op_MoreThenInt;
+		case Op_Less:           return Op_LessInt;
+		case Op_LessThen:       return Op_LessThenInt;
+		}
+		break;
+
+	case SVT_Double:
+		switch ( InOperation )
+		{
+		case Op_Assign:         return Op_AssignDouble;
+		case Op_Add:            return Op_AddDouble;
+		case Op_Substruct:      return Op_SubstructDouble;
+		case Op_Multiply:       return Op_MultiplyDouble;
+		case Op_Divide:         return Op_DivideDouble;
+		case Op_AddAssign:      return Op_AddAssignDouble;
+		case Op_Compare:        return Op_CompareDouble;
+		case Op_NotCompare:     return Op_NotCompareDouble;
+		case Op_More:           return Op_MoreDouble;
+		case Op_MoreThen:       return Op_MoreThenDouble;
+		case Op_Less:           return Op_LessDouble;
+		case Op_LessThen:       return Op_LessThenDouble;
+		}
+		break;
+
+	case SVT_String:
+		switch ( InOperation )
+		{
+		case Op_Add:            return Op_ConcatString;
+		case Op_AddAssign:      return Op_AppendString;
+		case Op_Compare:        return Op_CompareString;
+		case Op_NotCompare:     return Op_NotCompareString;
+		}
+		break;
+	}
+
+	return InOperation;
+}
+
+void FFunction::SpecializeTypes( const FCTranslator& InTranslator )
+{
+	// Local var has known type when all its declarations have one type, first declaration can't be skipped by jump,
+	// and nothing assigns value of other type to it. Set() changes type of var, so it's proven over whole function
+	std::vector<int>        jumps;
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		if ( GetOperationFormat( code[ i ] ) == OF_Jump )
+		{
+			jumps.push_back( i );
 		}
+	}
 
-		case Op_Add:
+	std::vector<int>        varTypes( numVars, -1 );
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		if ( code[ i ] != Op_AllocateVar )
 		{
-			int         leftVarId = code[ i + 1 ];
-			int         rightVarFlag = code[ i + 2 ];
-			int         rightVarId = code[ i + 3 ];
+			continue;
+		}
 
-			switch ( rightVarFlag )
+		int&    varType = varTypes[ code[ i + 2 ] ];
+		if ( varType == -1 )
+		{
+			varType = code[ i + 1 ];
+			for ( int jump : jumps )
 			{
-			case SVF_User:
-				registers[ SR_AX ]->Set( FScriptVar::Add( InFrame.vars[ leftVarId ], InFrame.vars[ rightVarId ] ) );
-				break;
+				if ( jump < i && code[ jump + 1 ] > i )
+				{
+					varType = SVT_None;
+					break;
+				}
+			}
+		}
+		else if ( varType != code[ i + 1 ] )
+		{
+			varType = SVT_None;
+		}
+	}
+
+	for ( int& varType : varTypes )
+	{
+		if ( varType == -1 )
+		{
+			varType = SVT_None;
+		}
+	}
+
+	// Virtual register is written once by arithmetic, so its type is type of result. Types of args are unknown, caller may pass any var
+	std::vector<int>        registerTypes( numRegisters, SVT_None );
+	auto                    GetOperandType = [&]( int InVarFlag, int InVarId ) -> int
+	{
+		switch ( InVarFlag )
+		{
+		case SVF_User:      return InVarId < numVars ? varTypes[ InVarId ] : SVT_None;
+		case SVF_Const:     return InTranslator.GetVarConstant( InVarId ).GetType();
+		case SVF_Register:  return registerTypes[ InVarId ];
+		default:            return SVT_None;
+		}
+	};
 
-			case SVF_Const:
-				registers[ SR_AX ]->Set( FScriptVar::Add( InFrame.vars[ leftVarId ], GCTranslator.GetVarConstant( rightVarId ) ) );
+	for ( bool isChanged = true; isChanged; )
+	{
+		isChanged = false;
+		for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+		{
+			switch ( code[ i ] )
+			{
+			case Op_Assign:
+			{
+				int     varType = GetOperandType( SVF_User, code[ i + 1 ] );
+				if ( varType != SVT_None && varType != GetOperandType( code[ i + 2 ], code[ i + 3 ] ) )
+				{
+					varTypes[ code[ i + 1 ] ] = SVT_None;
+					isChanged = true;
+				}
 				break;
+			}
 
-			case SVF_Arg:
-				registers[ SR_AX ]->Set( FScriptVar::Add( InFrame.vars[ leftVarId ], InFrame.args[ rightVarId ] ) );
+			case Op_Add:
+			case Op_Substruct:
+			case Op_Multiply:
+			case Op_Divide:
+			{
+				// On mismatch of types register isn't changed
+				int     leftType = GetOperandType( SVF_User, code[ i + 2 ] );
+				registerTypes[ code[ i + 1 ] ] = leftType == GetOperandType( code[ i + 3 ], code[ i + 4 ] ) ? leftType : SVT_None;
 				break;
+			}
 
-			default:
-				assert( false );
+			case Op_Call:
+			case Op_NativeCall:
+				// Callee can assign value of any type to its args, typed operations must not see changed var
+				for ( int j = 0; j < code[ i + 2 ]; ++j )
+				{
+					if ( code[ i + 3 + j * 2 ] == SVF_User && GetOperandType( SVF_User, code[ i + 4 + j * 2 ] ) != SVT_None )
+					{
+						varTypes[ code[ i + 4 + j * 2 ] ] = SVT_None;
+						isChanged = true;
+					}
+				}
 				break;
 			}
-
-			i += 4;
-			break;
+		}
+	}
+
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		int&    operation = code[ i ];
+		switch ( GetOperationFormat( operation ) )
+		{
+		case OF_Binary:
+		{
+			int     leftType = GetOperandType( SVF_User, code[ i + 1 ] );
+			if ( leftType == GetOperandType( code[ i + 2 ], code[ i + 3 ] ) )
+			{
+				operation = GetSpecializedOperation( operation, leftType );
+			}
+			break;
+		}
+
+		case OF_Arithmetic:
+		{
+			int     leftType = GetOperandType( SVF_User, code[ i + 2 ] );
+			if ( leftType == GetOperandType( code[ i + 3 ], code[ i + 4 ] ) )
+			{
+				operation = GetSpecializedOperation( operation, leftType );
+			}
+			break;
+		}
+
+		case OF_Compare:
+		{
+			int     leftType = GetOperandType( code[ i + 1 ], code[ i + 2 ] );
+			if ( leftType == GetOperandType( code[ i + 3 ], code[ i + 4 ] ) )
+			{
+				operation = GetSpecializedOperation( operation, leftType );
+			}
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+}
+
+// Superinstruction writing result of typed arithmetic InOperation directly to var, or Op_Nope if there is none
+static int GetFusedArithmetic( int InOperation )
+{
+	switch ( InOperation )
+	{
+	case Op_AddInt:             return Op_AddIntTo;
+	case Op_SubstructInt:       return Op_SubstructIntTo;
+	case Op_MultiplyInt:        return Op_MultiplyIntTo;
+	case Op_DivideInt:          return Op_DivideIntTo;
+	case Op_AddDouble:          return Op_AddDoubleTo;
+	case Op_SubstructDouble:    return Op_SubstructDoubleTo;
+	case Op_MultiplyDouble:     return Op_MultiplyDoubleTo;
+	case Op_DivideDouble:       return Op_DivideDoubleTo;
+	case Op_ConcatString:       return Op_ConcatStringTo;
+	default:                    return Op_Nope;
+	}
+}
+
+// Superinstruction for comparison InOperation followed by Op_JumpNotEqual, or Op_Nope if there is none
+static int GetFusedBranch( int InOperation )
+{
+	switch ( InOperation )
+	{
+	case Op_Compare:            return Op_CompareBranch;
+	case Op_NotCompare:         return Op_NotCompareBranch;
+	case Op_More:               return Op_MoreBranch;
+	case Op_MoreThen:           return Op_MoreThenBranch;
+	case Op_Less:               return Op_LessBranch;
+	case Op_LessThen:           return Op_LessThenBranch;
+	case Op_CompareInt:         return Op_CompareIntBranch;
+	case Op_NotCompareInt:      return Op_NotCompareIntBranch;
+	case Op_MoreInt:            return Op_MoreIntBranch;
+	case Op_MoreThenInt:        return Op_MoreThenIntBranch;
+	case Op_LessInt:            return Op_LessIntBranch;
+	case Op_LessThenInt:        return Op_LessThenIntBranch;
+	case Op_CompareDouble:      return Op_CompareDoubleBranch;
+	case Op_NotCompareDouble:   return Op_NotCompareDoubleBranch;
+	case Op_MoreDouble:         return Op_MoreDoubleBranch;
+	case Op_MoreThenDouble:     return Op_MoreThenDoubleBranch;
+	case Op_LessDouble:         return Op_LessDoubleBranch;
+	case Op_LessThenDouble:     return Op_LessThenDoubleBranch;
+	case Op_CompareString:      return Op_CompareStringBranch;
+	case Op_NotCompareString:   return Op_NotCompareStringBranch;
+	default:                    return Op_Nope;
+	}
+}
+
+// Rewrite targets of jumps in InOutCode by map of old positions of operations to new ones
+static void RelocateJumps( std::vector<int>& InOutCode, const std::vector<int>& InNewPositions )
+{
+	for ( int i = 0; i < InOutCode.size(); i += GetOperationSize( &InOutCode[ i ] ) )
+	{
+		switch ( GetOperationFormat( InOutCode[ i ] ) )
+		{
+		case OF_Jump:
+			InOutCode[ i + 1 ] = InNewPositions[ InOutCode[ i + 1 ] ];
+			assert( InOutCode[ i + 1 ] >= 0 );
+			break;
+
+		case OF_Branch:
+			InOutCode[ i + 5 ] = InNewPositions[ InOutCode[ i + 5 ] ];
+			assert( InOutCode[ i + 5 ] >= 0 );
+			break;
+
+		default:
+			break;
+		}
+	}
+}
+
+// Final target of jump to InTarget, skipping Op_Nope and following chains of Op_Jump
+static int ResolveJumpTarget( const std::vector<int>& InCode, int InTarget )
+{
+	int     target = InTarget;
+	for ( int i = 0; i < InCode.size() && target < InCode.size(); ++i )     // Bounded, jumps can form a cycle
+	{
+		if ( InCode[ target ] == Op_Nope )
+		{
+			++target;
+		}
+		else if ( InCode[ target ] == Op_Jump )
+		{
+			target = InCode[ target + 1 ];
+		}
+		else
+		{
+			break;
+		}
+	}
+	return target;
+}
+
+void FFunction::FuseOperations()
+{
+	// Operation which is target of jump can't be fused into previous one
+	std::vector<bool>       isJumpTarget( code.size() + 1, false );
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		if ( GetOperationFormat( code[ i ] ) == OF_Jump )
+		{
+			isJumpTarget[ code[ i + 1 ] ] = true;
+		}
+	}
+
+	// Register can be dropped only when assign is its single use
+	std::vector<int>        numRegisterOperands( numRegisters, 0 );
+	ForEachVarOperand( [&]( int InVarFlag, int InVarId )
+					   {
+						   if ( InVarFlag == SVF_Register )
+						   {
+							   ++numRegisterOperands[ InVarId ];
+						   }
+					   } );
+
+	std::vector<int>        newCode;
+	std::vector<int>        newPositions( code.size() + 1, -1 );
+	newCode.reserve( code.size() );
+	for ( int i = 0; i < code.size(); )
+	{
+		int     next = i + GetOperationSize( &code[ i ] );
+		newPositions[ i ] = newCode.size();
+
+		// x = a + b is Op_AddInt into register and assign of register to x. Typed arithmetic never leaves register
+		// unchanged, so writing result to x directly is the same
+		int     fusedOperation = GetFusedArithmetic( code[ i ] );
+		if ( fusedOperation != Op_Nope && next < code.size() && !isJumpTarget[ next ] &&
+			 ( code[ next ] == Op_Assign || code[ next ] == Op_AssignInt || code[ next ] == Op_AssignDouble ) &&
+			 code[ next + 2 ] == SVF_Register && code[ next + 3 ] == code[ i + 1 ] && numRegisterOperands[ code[ i + 1 ] ] == 2 )
+		{
+			newCode.push_back( fusedOperation );
+			newCode.push_back( code[ next + 1 ] );
+			newCode.insert( newCode.end(), code.begin() + i + 2, code.begin() + i + 5 );
+			i = next + 4;
+			continue;
+		}
+
+		fusedOperation = GetFusedBranch( code[ i ] );
+		if ( fusedOperation != Op_Nope && next < code.size() && !isJumpTarget[ next ] && code[ next ] == Op_JumpNotEqual )
+		{
+			newCode.push_back( fusedOperation );
+			newCode.insert( newCode.end(), code.begin() + i + 1, code.begin() + i + 5 );
+			newCode.push_back( code[ next + 1 ] );
+			i = next + 2;
+			continue;
+		}
+
+		newCode.insert( newCode.end(), code.begin() + i, code.begin() + next );
+		i = next;
+	}
+	newPositions[ code.size() ] = newCode.size();
+
+	RelocateJumps( newCode, newPositions );
+	code.swap( newCode );
+	code.shrink_to_fit();
+}
+
+void FFunction::OptimizeJumps()
+{
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		switch ( GetOperationFormat( code[ i ] ) )
+		{
+		case OF_Jump:
+			code[ i + 1 ] = ResolveJumpTarget( code, code[ i + 1 ] );
+			break;
+
+		case OF_Branch:
+			code[ i + 5 ] = ResolveJumpTarget( code, code[ i + 5 ] );
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	// After threading no jump lands on Op_Nope or Op_Jump, so they can be deleted
+	std::vector<int>        newCode;
+	std::vector<int>        newPositions( code.size() + 1, -1 );
+	newCode.reserve( code.size() );
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		newPositions[ i ] = newCode.size();
+		if ( code[ i ] == Op_Nope )
+		{
+			continue;
+		}
+
+		if ( code[ i ] == Op_Jump )
+		{
+			// Falling through reaches the same operation
+			if ( ResolveJumpTarget( code, i + 2 ) == code[ i + 1 ] )
+			{
+				continue;
+			}
+
+			if ( code[ code[ i + 1 ] ] == Op_Return )
+			{
+				newCode.push_back( Op_Return );
+				continue;
+			}
+		}
+
+		newCode.insert( newCode.end(), code.begin() + i, code.begin() + i + GetOperationSize( &code[ i ] ) );
+	}
+	newPositions[ code.size() ] = newCode.size();
+
+	RelocateJumps( newCode, newPositions );
+	code.swap( newCode );
+	code.shrink_to_fit();
+}
+
+void FFunction::AllocateRegisters()
+{
+	// Live interval of virtual register spans from its first to its last operand. Registers hold temporary results
+	// of one statement, so they are never live across jump
+	std::vector<int>        starts( numRegisters, -1 );
+	std::vector<int>        ends( numRegisters, -1 );
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		ForEachVarOperand( &code[ i ], [&]( int InVarFlag, int InVarId )
+										{
+											if ( InVarFlag == SVF_Register )
+											{
+												if ( starts[ InVarId ] == -1 )
+												{
+													starts[ InVarId ] = i;
+												}
+												ends[ InVarId ] = i;
+											}
+										} );
+	}
+
+	std::vector<int>        virtualRegisters;
+	for ( int i = 0; i < numRegisters; ++i )
+	{
+		if ( starts[ i ] != -1 )
+		{
+			virtualRegisters.push_back( i );
+		}
+	}
+	std::sort( virtualRegisters.begin(), virtualRegisters.end(), [&]( int InA, int InB ) { return starts[ InA ] < starts[ InB ]; } );
+
+	// Linear scan: free registers of expired intervals, then take lowest free register or add new one to frame
+	std::vector<int>        registers( numRegisters, -1 );
+	std::vector<int>        activeRegisters;
+	std::vector<int>        freeRegisters;
+	int                     numFrameRegisters = 0;
+	for ( int virtualRegister : virtualRegisters )
+	{
+		for ( int j = 0; j < activeRegisters.size(); )
+		{
+			if ( ends[ activeRegisters[ j ] ] < starts[ virtualRegister ] )
+			{
+				freeRegisters.push_back( registers[ activeRegisters[ j ] ] );
+				activeRegisters[ j ] = activeRegisters.back();
+				activeRegisters.pop_back();
+			}
+			else
+			{
+				++j;
+			}
+		}
+
+		if ( freeRegisters.empty() )
+		{
+			registers[ virtualRegister ] = numFrameRegisters++;
+		}
+		else
+		{
+			auto    itRegister = std::min_element( freeRegisters.begin(), freeRegisters.end() );
+			registers[ virtualRegister ] = *itRegister;
+			freeRegisters.erase( itRegister );
+		}
+		activeRegisters.push_back( virtualRegister );
+	}
+
+	ForEachVarOperand( [&]( int InVarFlag, int& InOutVarId )
+					   {
+						   if ( InVarFlag == SVF_Register )
+						   {
+							   InOutVarId = registers[ InOutVarId ];
+						   }
+					   } );
+	numRegisters = numFrameRegisters;
+}
+
+void FFunction::EliminateTailCalls()
+{
+	for ( int i = 0; i < code.size(); i += GetOperationSize( &code[ i ] ) )
+	{
+		int     next = i + GetOperationSize( &code[ i ] );
+		if ( code[ i ] == Op_Call && next < code.size() && code[ next ] == Op_Return )
+		{
+			code[ i ] = Op_TailCall;
+		}
+	}
+}
+
+void FFunction::DumpOperand( int InOperand ) const
+{
+	const FOperandSource&       operandSource = operandSources[ InOperand ];
+	switch ( operandSource.varFlag )
+	{
+	case SVF_User:
+		printf( " var%i", operandSource.varId );
+		break;
+
+	case SVF_Arg:
+		printf( " arg%i", operandSource.varId );
+		break;
+
+	case SVF_Register:
+		printf( " reg%i", operandSource.varId );
+		break;
+
+	case SVF_Const:
+	{
+		const FScriptVar&       varConstant = constants[ operandSource.varId ];
+		switch ( varConstant.GetType() )
+		{
+		case SVT_String:    printf( " \"%s\"", varConstant.GetString().c_str() ); break;
+		case SVT_Int:       printf( " %lld", ( long long ) varConstant.GetInt() ); break;
+		case SVT_Bool:      printf( " %s", varConstant.GetBool() ? "true" : "false" ); break;
+		case SVT_Double:    printf( " %g", varConstant.GetDouble() ); break;
+		default:            printf( " const%i", operandSource.varId ); break;
+		}
+		break;
+	}
+	}
+}
+
+void FFunction::DumpByteCode( const FCTranslator& InTranslator ) const
+{
+	printf( "%s: %i bytes (%i bytes unpacked), %i operands\n", name.c_str(), ( int ) linkedCode.size(), ( int ) ( code.size() * sizeof( int ) ), ( int ) operandSources.size() );
+
+	int                 operation;
+	std::vector<int>    operands;
+	for ( int i = 0; i < linkedCode.size(); )
+	{
+		int     size = DecodeOperation( &linkedCode[ i ], operation, operands );
+		printf( "%6i  %s", i, GetOperationName( operation ) );
+		switch ( GetOperationFormat( operation ) )
+		{
+		case OF_Call:
+		{
+			const FCallTarget&      callTarget = callTargets[ operands[ 0 ] ];
+			printf( " %s", callTarget.function ? callTarget.function->GetName().c_str() : InTranslator.GetNativeFunctionName( callTarget.functionId ).c_str() );
+			for ( int j = 2; j < operands.size(); ++j )
+			{
+				DumpOperand( operands[ j ] );
+			}
+			break;
+		}
+
+		case OF_AllocateVar:
+			printf( " %s", operands[ 0 ] == SVT_String ? "string" : operands[ 0 ] == SVT_Int ? "int" : operands[ 0 ] == SVT_Bool ? "bool" : "double" );
+			DumpOperand( operands[ 1 ] );
+			break;
+
+		case OF_Jump:
+			printf( " -> %i", operands[ 0 ] );
+			break;
+
+		case OF_Branch:
+			DumpOperand( operands[ 0 ] );
+			DumpOperand( operands[ 1 ] );
+			printf( " else -> %i", operands[ 2 ] );
+			break;
+
+		default:
+			for ( int operand : operands )
+			{
+				DumpOperand( operand );
+			}
+			break;
+		}
+		printf( "\n" );
+		i += size;
+	}
+}
+
+void FFunction::ReportExecutionError() const
+{
+	switch ( GExecutionState.error )
+	{
+	case EE_MemoryLimit:
+		if ( GExecutionState.isNoAllocation )
+		{
+			printf( "Error: string doesn't fit in reserved memory in zero-allocation execution of function '%s'\n", name.c_str() );
+		}
+		else
+		{
+			printf( "Error: heap memory limit exceeded in function '%s'\n", name.c_str() );
+		}
+		break;
+
+	case EE_IntegerOverflow:
+		printf( "Error: integer overflow in function '%s'\n", name.c_str() );
+		break;
+
+	case EE_DivideByZero:
+		printf( "Error: integer division by zero in function '%s'\n", name.c_str() );
+		break;
+
+	default:
+		break;
+	}
+}
+
+// Handlers are shared by both dispatch engines: SCRIPT_OP starts handler of opcode and SCRIPT_NEXT goes to next instruction,
+// SCRIPT_OPERAND reads operand of current instruction
+#define SCRIPT_OPERAND( InIndex )   ReadPackedOperand( byteCode + i + 1 + ( InIndex ) * sizeof( FPackedOperand ) )
+#if SCRIPT_THREADED_DISPATCH
+	#define SCRIPT_OP( InOp )       case InOp: Label_##InOp
+	#define SCRIPT_NEXT()           if ( InIsThreaded ) { goto *dispatchTable[ byteCode[ i ] ]; } break
+#else
+	#define SCRIPT_OP( InOp )       case InOp
+	#define SCRIPT_NEXT()           break
+#endif // SCRIPT_THREADED_DISPATCH
+
+// SCRIPT_FALLTHROUGH marks handler which continues into next one, fall through comment isn't seen before SCRIPT_OP expansion
+#if defined( __GNUC__ ) || defined( __clang__ )
+	#define SCRIPT_FALLTHROUGH      __attribute__( ( fallthrough ) )
+#else
+	#define SCRIPT_FALLTHROUGH
+#endif // __GNUC__ || __clang__
+
+// Operands of handlers: SCRIPT_VALUE reads operand, SCRIPT_VAR gives operand which is written. Only vars and registers are written,
+// constants are first operands of table and stay read-only
+#define SCRIPT_VALUE( InIndex )     ( *operands[ SCRIPT_OPERAND( InIndex ) ] )
+#define SCRIPT_VAR( InIndex )       GetVarOperand( operands, SCRIPT_OPERAND( InIndex ), function->GetNumConstants() )
+
+static inline FScriptVar& GetVarOperand( const FScriptVar* const* InOperands, int InOperand, int InNumConstants )
+{
+	assert( InOperand >= InNumConstants );
+	return const_cast<FScriptVar&>( *InOperands[ InOperand ] );
+}
+
+// Copy args of call from operand table. Args are passed by reference, constants are passed as they are when callee only reads them
+// and copied to values on stack when callee writes them. Constants are first InNumConstants operands
+inline int FFunction::CopyCallArgs( FScriptStack* InStack, FScriptVar** OutArgs, const FCallTarget& InCallTarget, const FScriptVar* const* InOperands, const uint8_t* InArgOperands, int InNumArgs, int InNumConstants )
+{
+	int     numConstantArgs = 0;
+	for ( int i = 0; i < InNumArgs; ++i )
+	{
+		int     operand = ReadPackedOperand( InArgOperands + i * sizeof( FPackedOperand ) );
+		if ( operand < InNumConstants && InCallTarget.IsArgWritten( i ) )
+		{
+			++numConstantArgs;
+		}
+		else
+		{
+			OutArgs[ i ] = const_cast<FScriptVar*>( InOperands[ operand ] );
+		}
+	}
+
+	if ( numConstantArgs == 0 )
+	{
+		return 0;
+	}
+
+	FScriptVar*     values = InStack->PushArgValues( numConstantArgs );
+	if ( !values )
+	{
+		return -1;
+	}
+
+	for ( int i = 0, j = 0; i < InNumArgs; ++i )
+	{
+		int     operand = ReadPackedOperand( InArgOperands + i * sizeof( FPackedOperand ) );
+		if ( operand < InNumConstants && InCallTarget.IsArgWritten( i ) )
+		{
+			values[ j ].Set( *InOperands[ operand ] );
+			OutArgs[ i ] = &values[ j ];
+			++j;
+		}
+	}
+	return numConstantArgs;
+}
+
+template<bool InIsThreaded>
+bool FFunction::ExecuteCode( FFrame& InFrame )
+{
+#if SCRIPT_THREADED_DISPATCH
+	// Order must match EScriptOperation
+	static void* const      dispatchTable[] =
+	{
+		&&Label_Op_Nope,
+		&&Label_Op_Call,
+		&&Label_Op_NativeCall,
+		&&Label_Op_AllocateVar,
+		&&Label_Op_Assign,
+		&&Label_Op_Compare,
+		&&Label_Op_NotCompare,
+		&&Label_Op_More,
+		&&Label_Op_MoreThen,
+		&&Label_Op_Less,
+		&&Label_Op_LessThen,
+		&&Label_Op_JumpNotEqual,
+		&&Label_Op_JumpEqual,
+		&&Label_Op_Jump,
+		&&Label_Op_Add,
+		&&Label_Op_Substruct,
+		&&Label_Op_Multiply,
+		&&Label_Op_Divide,
+		&&Label_Op_AddAssign,
+		&&Label_Op_Return,
+		&&Label_Op_AssignInt,
+		&&Label_Op_AssignDouble,
+		&&Label_Op_AddInt,
+		&&Label_Op_SubstructInt,
+		&&Label_Op_MultiplyInt,
+		&&Label_Op_DivideInt,
+		&&Label_Op_AddAssignInt,
+		&&Label_Op_AddDouble,
+		&&Label_Op_SubstructDouble,
+		&&Label_Op_MultiplyDouble,
+		&&Label_Op_DivideDouble,
+		&&Label_Op_AddAssignDouble,
+		&&Label_Op_ConcatString,
+		&&Label_Op_AppendString,
+		&&Label_Op_CompareInt,
+		&&Label_Op_NotCompareInt,
+		&&Label_Op_MoreInt,
+		&&Label_Op_MoreThenInt,
+		&&Label_Op_LessInt,
+		&&Label_Op_LessThenInt,
+		&&Label_Op_CompareDouble,
+		&&Label_Op_NotCompareDouble,
+		&&Label_Op_MoreDouble,
+		&&Label_Op_MoreThenDouble,
+		&&Label_Op_LessDouble,
+		&&Label_Op_LessThenDouble,
+		&&Label_Op_CompareString,
+		&&Label_Op_NotCompareString,
+		&&Label_Op_AddIntTo,
+		&&Label_Op_SubstructIntTo,
+		&&Label_Op_MultiplyIntTo,
+		&&Label_Op_DivideIntTo,
+		&&Label_Op_AddDoubleTo,
+		&&Label_Op_SubstructDoubleTo,
+		&&Label_Op_MultiplyDoubleTo,
+		&&Label_Op_DivideDoubleTo,
+		&&Label_Op_ConcatStringTo,
+		&&Label_Op_CompareBranch,
+		&&Label_Op_NotCompareBranch,
+		&&Label_Op_MoreBranch,
+		&&Label_Op_MoreThenBranch,
+		&&Label_Op_LessBranch,
+		&&Label_Op_LessThenBranch,
+		&&Label_Op_CompareIntBranch,
+		&&Label_Op_NotCompareIntBranch,
+		&&Label_Op_MoreIntBranch,
+		&&Label_Op_MoreThenIntBranch,
+		&&Label_Op_LessIntBranch,
+		&&Label_Op_LessThenIntBranch,
+		&&Label_Op_CompareDoubleBranch,
+		&&Label_Op_NotCompareDoubleBranch,
+		&&Label_Op_MoreDoubleBranch,
+		&&Label_Op_MoreThenDoubleBranch,
+		&&Label_Op_LessDoubleBranch,
+		&&Label_Op_LessThenDoubleBranch,
+		&&Label_Op_CompareStringBranch,
+		&&Label_Op_NotCompareStringBranch,
+		&&Label_Op_TailCall
+	};
+	static_assert( sizeof( dispatchTable ) / sizeof( dispatchTable[ 0 ] ) == Op_Num, "Dispatch table doesn't match EScriptOperation" );
+#endif // SCRIPT_THREADED_DISPATCH
+
+	// State of running function, switched by calls and returns
+	FFunction*      function = this;
+	const uint8_t*  byteCode = linkedCode.data();
+	const FScriptVar* const*    operands = InFrame.operands;
+	FScriptStack*   stack = InFrame.stack;
+	int             numCalls = stack->GetNumCalls();
+	bool            isCompareResult = false;
+
+	// Byte code always ends with Op_Return, so loop doesn't check bounds
+	for ( int i = 0; ; )
+	{
+#if SCRIPT_THREADED_DISPATCH
+		if ( InIsThreaded )
+		{
+			goto *dispatchTable[ byteCode[ i ] ];
+		}
+#endif // SCRIPT_THREADED_DISPATCH
+
+		switch ( byteCode[ i ] )
+		{
+		SCRIPT_OP( Op_Nope ):
+			++i;
+			SCRIPT_NEXT();
+
+		SCRIPT_OP( Op_TailCall ):
+			// Frame of first function belongs to native caller, so only frames of nested calls are reused
+			if ( stack->GetNumCalls() > numCalls )
+			{
+				const FCallTarget&  callTarget = function->callTargets[ SCRIPT_OPERAND( 0 ) ];
+				int                 numArgs = SCRIPT_OPERAND( 1 );
+				FCallRecord&        call = stack->GetTopCall();
+				FFrame&             frame = call.frame;
+
+				// Arguments are collected above operand table of current frame
+				FScriptVar**        args = stack->PushArgs( numArgs );
+				if ( !args )
+				{
+					printf( "Error: stack overflow in function '%s'\n", function->name.c_str() );
+					return false;
+				}
+
+				// Copies of constant args are pushed above frame, so they are kept like args pointing into frame
+				int                 numConstantArgs = CopyCallArgs( stack, args, callTarget, operands, byteCode + i + 1 + 2 * sizeof( FPackedOperand ), numArgs, function->GetNumConstants() );
+				int                 numArgValues = numConstantArgs < 0 ? -1 : stack->PopValuesForTailCall( frame.vars - call.numArgValues, args, numArgs );
+				if ( numArgValues < 0 )
+				{
+					stack->PopArgValues( std::max( numConstantArgs, 0 ) );
+					stack->PopArgs( numArgs );
+					printf( "Error: stack overflow in function '%s'\n", function->name.c_str() );
+					return false;
+				}
+
+				// Arguments replace arguments and operand table of current frame, return position of call stays
+				std::copy( args, args + numArgs, frame.args );
+				stack->PopArgs( frame.numArgs );
+				stack->PopOperands( function->operandSources.size() );
+				frame.numArgs = numArgs;
+				call.numArgValues = numArgValues;
+				if ( !callTarget.function->EnterFrame( frame ) )
+				{
+					stack->PopArgs( numArgs );
+					stack->PopArgValues( numArgValues );
+					stack->PopCall();
+					return false;
+				}
+
+				call.function = callTarget.function;
+				function = callTarget.function;
+				byteCode = function->linkedCode.data();
+				operands = frame.operands;
+				i = 0;
+				SCRIPT_NEXT();
+			}
+
+			// Only first frame is left, so it's entered like ordinary call
+			SCRIPT_FALLTHROUGH;
+
+		SCRIPT_OP( Op_Call ):
+		{
+			const FCallTarget&  callTarget = function->callTargets[ SCRIPT_OPERAND( 0 ) ];
+			int                 numArgs = SCRIPT_OPERAND( 1 );
+			FCallRecord*        call = stack->PushCall();
+			if ( !call )
+			{
+				printf( "Error: call depth limit exceeded in function '%s'\n", function->name.c_str() );
+				return false;
+			}
+
+			FFrame&             callFrame = call->frame;
+			callFrame.stack = stack;
+			callFrame.numArgs = numArgs;
+			callFrame.args = stack->PushArgs( numArgs );
+			if ( !callFrame.args )
+			{
+				stack->PopCall();
+				printf( "Error: stack overflow in function '%s'\n", function->name.c_str() );
+				return false;
+			}
+
+			call->numArgValues = CopyCallArgs( stack, callFrame.args, callTarget, operands, byteCode + i + 1 + 2 * sizeof( FPackedOperand ), numArgs, function->GetNumConstants() );
+			if ( call->numArgValues < 0 )
+			{
+				stack->PopArgs( numArgs );
+				stack->PopCall();
+				printf( "Error: stack overflow in function '%s'\n", function->name.c_str() );
+				return false;
+			}
+
+			if ( !callTarget.function->EnterFrame( callFrame ) )
+			{
+				stack->PopArgValues( call->numArgValues );
+				stack->PopArgs( numArgs );
+				stack->PopCall();
+				return false;
+			}
+
+			// Continue in callee, Op_Return switches back
+			call->function = callTarget.function;
+			call->returnPosition = i + 1 + ( 2 + numArgs ) * sizeof( FPackedOperand );
+			function = callTarget.function;
+			byteCode = function->linkedCode.data();
+			operands = callFrame.operands;
+			i = 0;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_NativeCall ):
+		{
+			const FCallTarget&  callTarget = function->callTargets[ SCRIPT_OPERAND( 0 ) ];
+			int                 numArgs = SCRIPT_OPERAND( 1 );
+			FFrame              callFrame;
+
+			callFrame.stack = InFrame.stack;
+			callFrame.numArgs = numArgs;
+			callFrame.args = stack->PushArgs( numArgs );
+			if ( !callFrame.args )
+			{
+				printf( "Error: stack overflow in function '%s'\n", function->name.c_str() );
+				return false;
+			}
+
+			int                 numArgValues = CopyCallArgs( stack, callFrame.args, callTarget, operands, byteCode + i + 1 + 2 * sizeof( FPackedOperand ), numArgs, function->GetNumConstants() );
+			if ( numArgValues < 0 )
+			{
+				stack->PopArgs( numArgs );
+				printf( "Error: stack overflow in function '%s'\n", function->name.c_str() );
+				return false;
+			}
+
+			callTarget.nativeFunctionFn( callFrame );
+			stack->PopArgValues( numArgValues );
+			stack->PopArgs( numArgs );
+
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 1 + ( 2 + numArgs ) * sizeof( FPackedOperand );
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AllocateVar ):
+		{
+			EScriptVarType  varType = ( EScriptVarType ) SCRIPT_OPERAND( 0 );
+			FScriptVar&     scriptVar = SCRIPT_VAR( 1 );
+
+			switch ( varType )
+			{
+			case SVT_Int:
+				scriptVar.SetInt( 0 );
+				break;
+
+			case SVT_String:
+				scriptVar.SetString( "" );
+				break;
+
+			case SVT_Bool:
+				scriptVar.SetBool( false );
+				break;
+
+			case SVT_Double:
+				scriptVar.SetDouble( 0.0 );
+				break;
+
+			default:
+				assert( false );
+				break;
+			}
+
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Assign ):
+		{
+			SCRIPT_VAR( 0 ).Set( SCRIPT_VALUE( 1 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Add ):
+		{
+			FScriptVar::AddInto( SCRIPT_VAR( 0 ), SCRIPT_VALUE( 1 ), SCRIPT_VALUE( 2 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AddAssign ):
+		{
+			FScriptVar::AddAssign( SCRIPT_VAR( 0 ), SCRIPT_VALUE( 1 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Substruct ):
+		{
+			FScriptVar::SubstructInto( SCRIPT_VAR( 0 ), SCRIPT_VALUE( 1 ), SCRIPT_VALUE( 2 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Multiply ):
+		{
+			FScriptVar::MultiplyInto( SCRIPT_VAR( 0 ), SCRIPT_VALUE( 1 ), SCRIPT_VALUE( 2 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Divide ):
+		{
+			FScriptVar::DivideInto( SCRIPT_VAR( 0 ), SCRIPT_VALUE( 1 ), SCRIPT_VALUE( 2 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Compare ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).Compare( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_NotCompare ):
+		{
+			isCompareResult = !SCRIPT_VALUE( 0 ).Compare( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_More ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).More( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreThen ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).MoreThen( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Less ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).Less( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessThen ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).LessThen( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_JumpNotEqual ):
+		{
+			if ( !isCompareResult )
+			{
+				i = SCRIPT_OPERAND( 0 );
+			}
+			else
+			{
+				i += 3;
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_JumpEqual ):
+		{
+			if ( isCompareResult )
+			{
+				i = SCRIPT_OPERAND( 0 );
+			}
+			else
+			{
+				i += 3;
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_Jump ):
+		{
+			i = SCRIPT_OPERAND( 0 );
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AssignInt ):
+		{
+			SCRIPT_VAR( 0 ).GetIntRef() = SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AssignDouble ):
+		{
+			SCRIPT_VAR( 0 ).GetDoubleRef() = SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AddInt ):
+		SCRIPT_OP( Op_AddIntTo ):
+		{
+			int64_t     result;
+			if ( !CheckedAdd( SCRIPT_VALUE( 1 ).GetIntRef(), SCRIPT_VALUE( 2 ).GetIntRef(), result ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				function->ReportExecutionError();
+				return false;
+			}
+
+			SCRIPT_VAR( 0 ).SetInt( result );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_SubstructInt ):
+		SCRIPT_OP( Op_SubstructIntTo ):
+		{
+			int64_t     result;
+			if ( !CheckedSubstruct( SCRIPT_VALUE( 1 ).GetIntRef(), SCRIPT_VALUE( 2 ).GetIntRef(), result ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				function->ReportExecutionError();
+				return false;
+			}
+
+			SCRIPT_VAR( 0 ).SetInt( result );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MultiplyInt ):
+		SCRIPT_OP( Op_MultiplyIntTo ):
+		{
+			int64_t     result;
+			if ( !CheckedMultiply( SCRIPT_VALUE( 1 ).GetIntRef(), SCRIPT_VALUE( 2 ).GetIntRef(), result ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				function->ReportExecutionError();
+				return false;
+			}
+
+			SCRIPT_VAR( 0 ).SetInt( result );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_DivideInt ):
+		SCRIPT_OP( Op_DivideIntTo ):
+		{
+			int64_t     left = SCRIPT_VALUE( 1 ).GetIntRef();
+			int64_t     right = SCRIPT_VALUE( 2 ).GetIntRef();
+			if ( right == 0 || ( left == INT64_MIN && right == -1 ) )
+			{
+				GExecutionState.error = right == 0 ? EE_DivideByZero : EE_IntegerOverflow;
+				function->ReportExecutionError();
+				return false;
+			}
+
+			SCRIPT_VAR( 0 ).SetInt( left / right );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AddAssignInt ):
+		{
+			int64_t&    left = SCRIPT_VAR( 0 ).GetIntRef();
+			if ( !CheckedAdd( left, SCRIPT_VALUE( 1 ).GetIntRef(), left ) )
+			{
+				GExecutionState.error = EE_IntegerOverflow;
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AddDouble ):
+		SCRIPT_OP( Op_AddDoubleTo ):
+		{
+			SCRIPT_VAR( 0 ).SetDouble( SCRIPT_VALUE( 1 ).GetDoubleRef() + SCRIPT_VALUE( 2 ).GetDoubleRef() );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_SubstructDouble ):
+		SCRIPT_OP( Op_SubstructDoubleTo ):
+		{
+			SCRIPT_VAR( 0 ).SetDouble( SCRIPT_VALUE( 1 ).GetDoubleRef() - SCRIPT_VALUE( 2 ).GetDoubleRef() );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MultiplyDouble ):
+		SCRIPT_OP( Op_MultiplyDoubleTo ):
+		{
+			SCRIPT_VAR( 0 ).SetDouble( SCRIPT_VALUE( 1 ).GetDoubleRef() * SCRIPT_VALUE( 2 ).GetDoubleRef() );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_DivideDouble ):
+		SCRIPT_OP( Op_DivideDoubleTo ):
+		{
+			SCRIPT_VAR( 0 ).SetDouble( SCRIPT_VALUE( 1 ).GetDoubleRef() / SCRIPT_VALUE( 2 ).GetDoubleRef() );
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AddAssignDouble ):
+		{
+			SCRIPT_VAR( 0 ).GetDoubleRef() += SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_ConcatString ):
+		SCRIPT_OP( Op_ConcatStringTo ):
+		{
+			FScriptVar::ConcatInto( SCRIPT_VAR( 0 ), SCRIPT_VALUE( 1 ), SCRIPT_VALUE( 2 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 7;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_AppendString ):
+		{
+			SCRIPT_VAR( 0 ).Append( SCRIPT_VALUE( 1 ) );
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_CompareInt ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetIntRef() == SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_NotCompareInt ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetIntRef() != SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreInt ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetIntRef() > SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreThenInt ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetIntRef() >= SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessInt ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetIntRef() < SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessThenInt ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetIntRef() <= SCRIPT_VALUE( 1 ).GetIntRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_CompareDouble ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetDoubleRef() == SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_NotCompareDouble ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetDoubleRef() != SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreDouble ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetDoubleRef() > SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreThenDouble ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetDoubleRef() >= SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessDouble ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetDoubleRef() < SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessThenDouble ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).GetDoubleRef() <= SCRIPT_VALUE( 1 ).GetDoubleRef();
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_CompareString ):
+		{
+			isCompareResult = SCRIPT_VALUE( 0 ).CompareString( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_NotCompareString ):
+		{
+			isCompareResult = !SCRIPT_VALUE( 0 ).CompareString( SCRIPT_VALUE( 1 ) );
+			i += 5;
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_CompareBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).Compare( SCRIPT_VALUE( 1 ) ) )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_NotCompareBranch ):
+		{
+			if ( !SCRIPT_VALUE( 0 ).Compare( SCRIPT_VALUE( 1 ) ) )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).More( SCRIPT_VALUE( 1 ) ) )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_MoreThenBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).MoreThen( SCRIPT_VALUE( 1 ) ) )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).Less( SCRIPT_VALUE( 1 ) ) )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_LessThenBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).LessThen( SCRIPT_VALUE( 1 ) ) )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
+
+		SCRIPT_OP( Op_CompareIntBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).GetIntRef() == SCRIPT_VALUE( 1 ).GetIntRef() )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
 		}
 
-		case Op_Substruct:
+		SCRIPT_OP( Op_NotCompareIntBranch ):
 		{
-			int         leftVarId = code[ i + 1 ];
-			int         rightVarFlag = code[ i + 2 ];
-			int         rightVarId = code[ i + 3 ];
-
-			switch ( rightVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetIntRef() != SCRIPT_VALUE( 1 ).GetIntRef() )
 			{
-			case SVF_User:
-				registers[ SR_AX ]->Set( FScriptVar::Substruct( InFrame.vars[ leftVarId ], InFrame.vars[ rightVarId ] ) );
-				break;
-
-			case SVF_Const:
-				registers[ SR_AX ]->Set( FScriptVar::Substruct( InFrame.vars[ leftVarId ], GCTranslator.GetVarConstant( rightVarId ) ) );
-				break;
-
-			case SVF_Arg:
-				registers[ SR_AX ]->Set( FScriptVar::Substruct( InFrame.vars[ leftVarId ], InFrame.args[ rightVarId ] ) );
-				break;
-
-			default:
-				assert( false );
-				break;
+				i += 7;
 			}
-
-			i += 4;
-			break;
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
 		}
 
-		case Op_Multiply:
+		SCRIPT_OP( Op_MoreIntBranch ):
 		{
-			int         leftVarId = code[ i + 1 ];
-			int         rightVarFlag = code[ i + 2 ];
-			int         rightVarId = code[ i + 3 ];
-
-			switch ( rightVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetIntRef() > SCRIPT_VALUE( 1 ).GetIntRef() )
 			{
-			case SVF_User:
-				registers[ SR_AX ]->Set( FScriptVar::Multiply( InFrame.vars[ leftVarId ], InFrame.vars[ rightVarId ] ) );
-				break;
-
-			case SVF_Const:
-				registers[ SR_AX ]->Set( FScriptVar::Multiply( InFrame.vars[ leftVarId ], GCTranslator.GetVarConstant( rightVarId ) ) );
-				break;
-
-			case SVF_Arg:
-				registers[ SR_AX ]->Set( FScriptVar::Multiply( InFrame.vars[ leftVarId ], InFrame.args[ rightVarId ] ) );
-				break;
-
-			default:
-				assert( false );
-				break;
+				i += 7;
 			}
-
-			i += 4;
-			break;
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
 		}
 
-		case Op_Divide:
+		SCRIPT_OP( Op_MoreThenIntBranch ):
 		{
-			int         leftVarId = code[ i + 1 ];
-			int         rightVarFlag = code[ i + 2 ];
-			int         rightVarId = code[ i + 3 ];
-
-			switch ( rightVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetIntRef() >= SCRIPT_VALUE( 1 ).GetIntRef() )
 			{
-			case SVF_User:
-				registers[ SR_AX ]->Set( FScriptVar::Divide( InFrame.vars[ leftVarId ], InFrame.vars[ rightVarId ] ) );
-				break;
-
-			case SVF_Const:
-				registers[ SR_AX ]->Set( FScriptVar::Divide( InFrame.vars[ leftVarId ], GCTranslator.GetVarConstant( rightVarId ) ) );
-				break;
-
-			case SVF_Arg:
-				registers[ SR_AX ]->Set( FScriptVar::Divide( InFrame.vars[ leftVarId ], InFrame.args[ rightVarId ] ) );
-				break;
-
-			default:
-				assert( false );
-				break;
+				i += 7;
 			}
-
-			i += 4;
-			break;
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
 		}
 
-		case Op_Compare:
+		SCRIPT_OP( Op_LessIntBranch ):
 		{
-			int         leftVarFlag = code[ i + 1 ];
-			int         leftVarId = code[ i + 2 ];
-			int         rightVarFlag = code[ i + 3 ];
-			int         rightVarId = code[ i + 4 ];
-
-			std::shared_ptr<FScriptVar>  leftVar;
-			std::shared_ptr<FScriptVar>  rightVar;
-
-			switch ( leftVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetIntRef() < SCRIPT_VALUE( 1 ).GetIntRef() )
 			{
-			case SVF_User:
-				leftVar = InFrame.vars[ leftVarId ];
-				break;
-
-			case SVF_Const:
-				leftVar = GCTranslator.GetVarConstant( leftVarId );
-				break;
-
-			case SVF_Arg:
-				leftVar = InFrame.args[ leftVarId ];
-				break;
+				i += 7;
 			}
-
-			switch ( rightVarFlag )
+			else
 			{
-			case SVF_User:
-				rightVar = InFrame.vars[ rightVarId ];
-				break;
-
-			case SVF_Const:
-				rightVar = GCTranslator.GetVarConstant( rightVarId );
-				break;
-
-			case SVF_Arg:
-				rightVar = InFrame.args[ rightVarId ];
-				break;
+				i = SCRIPT_OPERAND( 2 );
 			}
-
-			isCompareResult = leftVar->Compare( rightVar );
-			i += 5;
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_NotCompare:
+		SCRIPT_OP( Op_LessThenIntBranch ):
 		{
-			int         leftVarFlag = code[ i + 1 ];
-			int         leftVarId = code[ i + 2 ];
-			int         rightVarFlag = code[ i + 3 ];
-			int         rightVarId = code[ i + 4 ];
-
-			std::shared_ptr<FScriptVar>  leftVar;
-			std::shared_ptr<FScriptVar>  rightVar;
-
-			switch ( leftVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetIntRef() <= SCRIPT_VALUE( 1 ).GetIntRef() )
 			{
-			case SVF_User:
-				leftVar = InFrame.vars[ leftVarId ];
-				break;
-
-			case SVF_Const:
-				leftVar = GCTranslator.GetVarConstant( leftVarId );
-				break;
-
-			case SVF_Arg:
-				leftVar = InFrame.args[ leftVarId ];
-				break;
+				i += 7;
 			}
-
-			switch ( rightVarFlag )
+			else
 			{
-			case SVF_User:
-				rightVar = InFrame.vars[ rightVarId ];
-				break;
-
-			case SVF_Const:
-				rightVar = GCTranslator.GetVarConstant( rightVarId );
-				break;
-
-			case SVF_Arg:
-				rightVar = InFrame.args[ rightVarId ];
-				break;
+				i = SCRIPT_OPERAND( 2 );
 			}
-
-			isCompareResult = !leftVar->Compare( rightVar );
-			i += 5;
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_More:
+		SCRIPT_OP( Op_CompareDoubleBranch ):
 		{
-			int         leftVarFlag = code[ i + 1 ];
-			int         leftVarId = code[ i + 2 ];
-			int         rightVarFlag = code[ i + 3 ];
-			int         rightVarId = code[ i + 4 ];
-
-			std::shared_ptr<FScriptVar>  leftVar;
-			std::shared_ptr<FScriptVar>  rightVar;
-
-			switch ( leftVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetDoubleRef() == SCRIPT_VALUE( 1 ).GetDoubleRef() )
 			{
-			case SVF_User:
-				leftVar = InFrame.vars[ leftVarId ];
-				break;
-
-			case SVF_Const:
-				leftVar = GCTranslator.GetVarConstant( leftVarId );
-				break;
-
-			case SVF_Arg:
-				leftVar = InFrame.args[ leftVarId ];
-				break;
+				i += 7;
 			}
-
-			switch ( rightVarFlag )
+			else
 			{
-			case SVF_User:
-				rightVar = InFrame.vars[ rightVarId ];
-				break;
-
-			case SVF_Const:
-				rightVar = GCTranslator.GetVarConstant( rightVarId );
-				break;
-
-			case SVF_Arg:
-				rightVar = InFrame.args[ rightVarId ];
-				break;
+				i = SCRIPT_OPERAND( 2 );
 			}
-
-			isCompareResult = leftVar->More( rightVar );
-			i += 5;
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_MoreThen:
+		SCRIPT_OP( Op_NotCompareDoubleBranch ):
 		{
-			int         leftVarFlag = code[ i + 1 ];
-			int         leftVarId = code[ i + 2 ];
-			int         rightVarFlag = code[ i + 3 ];
-			int         rightVarId = code[ i + 4 ];
-
-			std::shared_ptr<FScriptVar>  leftVar;
-			std::shared_ptr<FScriptVar>  rightVar;
-
-			switch ( leftVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetDoubleRef() != SCRIPT_VALUE( 1 ).GetDoubleRef() )
 			{
-			case SVF_User:
-				leftVar = InFrame.vars[ leftVarId ];
-				break;
-
-			case SVF_Const:
-				leftVar = GCTranslator.GetVarConstant( leftVarId );
-				break;
-
-			case SVF_Arg:
-				leftVar = InFrame.args[ leftVarId ];
-				break;
+				i += 7;
 			}
-
-			switch ( rightVarFlag )
+			else
 			{
-			case SVF_User:
-				rightVar = InFrame.vars[ rightVarId ];
-				break;
-
-			case SVF_Const:
-				rightVar = GCTranslator.GetVarConstant( rightVarId );
-				break;
-
-			case SVF_Arg:
-				rightVar = InFrame.args[ rightVarId ];
-				break;
+				i = SCRIPT_OPERAND( 2 );
 			}
-
-			isCompareResult = leftVar->MoreThen( rightVar );
-			i += 5;
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_Less:
+		SCRIPT_OP( Op_MoreDoubleBranch ):
 		{
-			int         leftVarFlag = code[ i + 1 ];
-			int         leftVarId = code[ i + 2 ];
-			int         rightVarFlag = code[ i + 3 ];
-			int         rightVarId = code[ i + 4 ];
-
-			std::shared_ptr<FScriptVar>  leftVar;
-			std::shared_ptr<FScriptVar>  rightVar;
-
-			switch ( leftVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetDoubleRef() > SCRIPT_VALUE( 1 ).GetDoubleRef() )
 			{
-			case SVF_User:
-				leftVar = InFrame.vars[ leftVarId ];
-				break;
-
-			case SVF_Const:
-				leftVar = GCTranslator.GetVarConstant( leftVarId );
-				break;
-
-			case SVF_Arg:
-				leftVar = InFrame.args[ leftVarId ];
-				break;
+				i += 7;
 			}
-
-			switch ( rightVarFlag )
+			else
 			{
-			case SVF_User:
-				rightVar = InFrame.vars[ rightVarId ];
-				break;
-
-			case SVF_Const:
-				rightVar = GCTranslator.GetVarConstant( rightVarId );
-				break;
-
-			case SVF_Arg:
-				rightVar = InFrame.args[ rightVarId ];
-				break;
+				i = SCRIPT_OPERAND( 2 );
 			}
-
-			isCompareResult = leftVar->Less( rightVar );
-			i += 5;
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_LessThen:
+		SCRIPT_OP( Op_MoreThenDoubleBranch ):
 		{
-			int         leftVarFlag = code[ i + 1 ];
-			int         leftVarId = code[ i + 2 ];
-			int         rightVarFlag = code[ i + 3 ];
-			int         rightVarId = code[ i + 4 ];
-
-			std::shared_ptr<FScriptVar>  leftVar;
-			std::shared_ptr<FScriptVar>  rightVar;
-
-			switch ( leftVarFlag )
+			if ( SCRIPT_VALUE( 0 ).GetDoubleRef() >= SCRIPT_VALUE( 1 ).GetDoubleRef() )
 			{
-			case SVF_User:
-				leftVar = InFrame.vars[ leftVarId ];
-				break;
-
-			case SVF_Const:
-				leftVar = GCTranslator.GetVarConstant( leftVarId );
-				break;
-
-			case SVF_Arg:
-				leftVar = InFrame.args[ leftVarId ];
-				break;
+				i += 7;
 			}
-
-			switch ( rightVarFlag )
+			else
 			{
-			case SVF_User:
-				rightVar = InFrame.vars[ rightVarId ];
-				break;
-
-			case SVF_Const:
-				rightVar = GCTranslator.GetVarConstant( rightVarId );
-				break;
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
+		}
 
-			case SVF_Arg:
-				rightVar = InFrame.args[ rightVarId ];
-				break;
+		SCRIPT_OP( Op_LessDoubleBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).GetDoubleRef() < SCRIPT_VALUE( 1 ).GetDoubleRef() )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
 			}
+			SCRIPT_NEXT();
+		}
 
-			isCompareResult = leftVar->LessThen( rightVar );
-			i += 5;
-			break;
+		SCRIPT_OP( Op_LessThenDoubleBranch ):
+		{
+			if ( SCRIPT_VALUE( 0 ).GetDoubleRef() <= SCRIPT_VALUE( 1 ).GetDoubleRef() )
+			{
+				i += 7;
+			}
+			else
+			{
+				i = SCRIPT_OPERAND( 2 );
+			}
+			SCRIPT_NEXT();
 		}
 
-		case Op_JumpNotEqual:
+		SCRIPT_OP( Op_CompareStringBranch ):
 		{
-			if ( !isCompareResult )
+			if ( SCRIPT_VALUE( 0 ).CompareString( SCRIPT_VALUE( 1 ) ) )
 			{
-				i = code[ i + 1 ];
+				i += 7;
 			}
 			else
 			{
-				i += 2;
+				i = SCRIPT_OPERAND( 2 );
 			}
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_JumpEqual:
+		SCRIPT_OP( Op_NotCompareStringBranch ):
 		{
-			if ( isCompareResult )
+			if ( !SCRIPT_VALUE( 0 ).CompareString( SCRIPT_VALUE( 1 ) ) )
 			{
-				i = code[ i + 1 ];
+				i += 7;
 			}
 			else
 			{
-				i += 2;
+				i = SCRIPT_OPERAND( 2 );
 			}
-			break;
+			SCRIPT_NEXT();
 		}
 
-		case Op_Jump:
+		SCRIPT_OP( Op_Return ):
 		{
-			i = code[ i + 1 ];
-			break;
+			if ( stack->GetNumCalls() == numCalls )
+			{
+				return true;
+			}
+
+			// Leave frame of callee and continue caller after call
+			FCallRecord&    call = stack->GetTopCall();
+			function->LeaveFrame( call.frame );
+			stack->PopArgs( call.frame.numArgs );
+			stack->PopArgValues( call.numArgValues );
+			i = call.returnPosition;
+			stack->PopCall();
+
+			FFrame&         frame = stack->GetNumCalls() == numCalls ? InFrame : stack->GetTopCall().frame;
+			function = stack->GetNumCalls() == numCalls ? this : stack->GetTopCall().function;
+			byteCode = function->linkedCode.data();
+			operands = frame.operands;
+			if ( GExecutionState.error != EE_None )
+			{
+				function->ReportExecutionError();
+				return false;
+			}
+			SCRIPT_NEXT();
 		}
 
 		default:
-			++i;
-			break;
+			assert( false );
+			return false;
+		}
+	}
+}
+
+#undef SCRIPT_OP
+#undef SCRIPT_VALUE
+#undef SCRIPT_VAR
+#undef SCRIPT_NEXT
+#undef SCRIPT_OPERAND
+#undef SCRIPT_FALLTHROUGH
+
+struct FBenchmarkInfo
+{
+	const char*     functionName;       // Script function name
+	const char*     operationName;      // Name of measured operation
+	int             numOperations;      // Number of measured operations in one call
+};
+
+// Source code of benchmark scripts
+const char* GBenchmarkSourceCode =
+	"void Bench_Add()\n"
+	"{\n"
+	"	int i;\n"
+	"	int a;\n"
+	"	i = 0;\n"
+	"	a = 0;\n"
+	"	while ( i < 100000 )\n"
+	"	{\n"
+	"		a = a + 1;\n"
+	"		i = i + 1;\n"
+	"	}\n"
+	"}\n"
+	"void Bench_Helper( int a, int b )\n"
+	"{\n"
+	"	int c;\n"
+	"	c = a;\n"
+	"}\n"
+	"void Bench_Call()\n"
+	"{\n"
+	"	int i;\n"
+	"	i = 0;\n"
+	"	while ( i < 100000 )\n"
+	"	{\n"
+	"		Bench_Helper( i, i );\n"
+	"		i = i + 1;\n"
+	"	}\n"
+	"}\n"
+	"void Bench_Countdown( int n )\n"
+	"{\n"
+	"	int i;\n"
+	"	i = n;\n"
+	"	if ( i > 0 )\n"
+	"	{\n"
+	"		i = i - 1;\n"
+	"		Bench_Countdown( i );\n"
+	"		return;\n"
+	"	}\n"
+	"}\n"
+	"void Bench_TailCall()\n"
+	"{\n"
+	"	int i;\n"
+	"	i = 100000;\n"
+	"	Bench_Countdown( i );\n"
+	"}\n"
+	"void Check_WriteArg( int x )\n"
+	"{\n"
+	"	Check_SetArg( x );\n"
+	"}\n"
+	"void Check_TailWriteArg()\n"
+	"{\n"
+	"	Check_WriteArg( 5 );\n"
+	"}\n"
+	"void Check_ConstantArgs()\n"
+	"{\n"
+	"	int expected;\n"
+	"	expected = 2;\n"
+	"	expected = expected + 3;\n"
+	"	Check_WriteArg( 5 );\n"
+	"	Check_TailWriteArg();\n"
+	"	Check_SetArg( 5 );\n"
+	"	Check_Expect( 5, expected );\n"
+	"}\n"
+	"void Bench_StringCompare()\n"
+	"{\n"
+	"	int i;\n"
+	"	string state;\n"
+	"	i = 0;\n"
+	"	state = \"waiting for user input\";\n"
+	"	while ( i < 100000 )\n"
+	"	{\n"
+	"		if ( state != \"waiting for user input\" )\n"
+	"		{\n"
+	"			i = i + 1;\n"
+	"		}\n"
+	"		i = i + 1;\n"
+	"	}\n"
+	"}\n"
+	"void Bench_String()\n"
+	"{\n"
+	"	int i;\n"
+	"	string name;\n"
+	"	string greeting;\n"
+	"	string text;\n"
+	"	i = 0;\n"
+	"	name = \"user name from the input\";\n"
+	"	greeting = \"hello, \";\n"
+	"	while ( i < 100000 )\n"
+	"	{\n"
+	"		text = greeting + name;\n"
+	"		if ( text == name )\n"
+	"		{\n"
+	"			name = text;\n"
+	"		}\n"
+	"		greeting = greeting;\n"
+	"		i = i + 1;\n"
+	"	}\n"
+	"}\n"
+	"void Bench_Concat()\n"
+	"{\n"
+	"	int i;\n"
+	"	string text;\n"
+	"	i = 0;\n"
+	"	while ( i < 100000 )\n"
+	"	{\n"
+	"		text = text + \"line \";\n"
+	"		i = i + 1;\n"
+	"	}\n"
+	"}\n";
+
+// Checks of interpreter behaviour, run before benchmarks. Check fails if Check_Expect gets different values
+const char* GBenchmarkChecks[] =
+{
+	"Check_ConstantArgs"
+};
+
+bool        GIsBenchmarkCheckFailed = false;
+
+// Overwrite args like scan does
+void execCheckSetArg( FFrame& InFrame )
+{
+	for ( int i = 0; i < InFrame.numArgs; ++i )
+	{
+		InFrame.args[ i ]->SetInt( 42 );
+	}
+}
+
+void execCheckExpect( FFrame& InFrame )
+{
+	if ( InFrame.numArgs != 2 || !FScriptVar::FEqualFunc()( *InFrame.args[ 0 ], *InFrame.args[ 1 ] ) )
+	{
+		GIsBenchmarkCheckFailed = true;
+	}
+}
+
+// Benchmarks
+const FBenchmarkInfo GBenchmarks[] =
+{
+	{ "Bench_Add", "Op_Add", 200000 },
+	{ "Bench_Call", "Op_Call", 100000 },
+	{ "Bench_TailCall", "Op_TailCall", 100000 },
+	{ "Bench_StringCompare", "Op_NotCompare", 100000 },
+	{ "Bench_String", "iteration", 100000 },
+	{ "Bench_Concat", "Op_AddAssign", 100000 }
+};
+
+// Script run by zero-allocation check and its input, path is relative to project directory or to repository
+const char*         GNoAllocationCheckPaths[] = { "../src.c", "src.c" };
+const char*         GNoAllocationCheckInput = "3 word 1";
+
+// Preflight and run main of src.c in zero-allocation mode, check fails if execution allocates heap memory.
+// Return false if src.c not found
+bool CheckNoAllocation( bool& OutIsPassed )
+{
+	const char*     path = nullptr;
+	for ( int i = 0; i < sizeof( GNoAllocationCheckPaths ) / sizeof( GNoAllocationCheckPaths[ 0 ] ) && !path; ++i )
+	{
+		if ( std::ifstream( GNoAllocationCheckPaths[ i ] ).is_open() )
+		{
+			path = GNoAllocationCheckPaths[ i ];
+		}
+	}
+
+	if ( !path )
+	{
+		return false;
+	}
+
+	FCTranslator        translator;
+	FPreflightInfo      preflightInfo;
+	translator.Init();
+	OutIsPassed = translator.LoadFromFile( path ) && translator.Preflight( "main", preflightInfo );
+	if ( !OutIsPassed )
+	{
+		return true;
+	}
+
+	// Scan of script reads prepared input instead of console
+	std::istringstream  input( GNoAllocationCheckInput );
+	std::streambuf*     oldBuffer = std::cin.rdbuf( input.rdbuf() );
+
+	FFrame              frame;
+	FExecuteOptions     options;
+	FExecutionStats     stats;
+	options.isNoAllocation = true;
+	OutIsPassed = translator.ExecuteFunction( "main", frame, options, &stats ) && stats.numHeapAllocations == 0;
+	std::cin.rdbuf( oldBuffer );
+	return true;
+}
+
+void RunBenchmarks( FCTranslator& InTranslator, int InNumRuns );
+
+void RunBenchmarks()
+{
+	// Benchmarks have own translator, so they don't mix with scripts loaded by user
+	static FCTranslator     benchmarkTranslator;
+	static bool             isLoaded = false;
+	if ( !isLoaded )
+	{
+		benchmarkTranslator.RegisterNativeFunction( "Check_SetArg", &execCheckSetArg, true );
+		benchmarkTranslator.RegisterNativeFunction( "Check_Expect", &execCheckExpect );
+		isLoaded = benchmarkTranslator.LoadFromString( GBenchmarkSourceCode );
+		if ( !isLoaded )
+		{
+			return;
+		}
+	}
+
+	for ( int i = 0; i < sizeof( GBenchmarkChecks ) / sizeof( GBenchmarkChecks[ 0 ] ); ++i )
+	{
+		FFrame      frame;
+		GIsBenchmarkCheckFailed = false;
+		bool        bResult = benchmarkTranslator.ExecuteFunction( GBenchmarkChecks[ i ], frame ) && !GIsBenchmarkCheckFailed;
+		printf( "%s: %s\n", GBenchmarkChecks[ i ], bResult ? "passed" : "failed" );
+	}
+
+	bool            isNoAllocationPassed = false;
+	if ( CheckNoAllocation( isNoAllocationPassed ) )
+	{
+		printf( "Check_NoAllocation: %s\n", isNoAllocationPassed ? "passed" : "failed" );
+	}
+	else
+	{
+		printf( "Check_NoAllocation: skipped, src.c not found\n" );
+	}
+
+#if SCRIPT_THREADED_DISPATCH
+	const int       numEngines = 2;
+#else
+	const int       numEngines = 1;
+#endif // SCRIPT_THREADED_DISPATCH
+
+	bool            isOldThreadedDispatch = GIsThreadedDispatch;
+	for ( int engine = 0; engine < numEngines; ++engine )
+	{
+		GIsThreadedDispatch = engine == 1;
+		printf( "%s dispatch:\n", GIsThreadedDispatch ? "Threaded" : "Switch" );
+		RunBenchmarks( benchmarkTranslator, 10 );
+	}
+	GIsThreadedDispatch = isOldThreadedDispatch;
+}
+
+void RunBenchmarks( FCTranslator& InTranslator, int InNumRuns )
+{
+	const int       numRuns = InNumRuns;
+	for ( int i = 0; i < sizeof( GBenchmarks ) / sizeof( GBenchmarks[ 0 ] ); ++i )
+	{
+		const FBenchmarkInfo& benchmark = GBenchmarks[ i ];
+		std::size_t     totalNumAllocations = 0;
+		auto            startTime = std::chrono::high_resolution_clock::now();
+
+		// Allocations are counted by execution, operator new doesn't count them outside of scripts
+		for ( int run = 0; run < numRuns; ++run )
+		{
+			FFrame              frame;
+			FExecutionStats     stats;
+			InTranslator.ExecuteFunction( benchmark.functionName, frame, FExecuteOptions(), &stats );
+			totalNumAllocations += stats.numHeapAllocations;
 		}
+
+		double          elapsedMs = std::chrono::duration<double, std::milli>( std::chrono::high_resolution_clock::now() - startTime ).count() / numRuns;
+#if SCRIPT_HEAP_STATS
+		double          numAllocations = double( totalNumAllocations ) / numRuns;
+		printf( "%s: %.3f ms per call, %.0f allocations per call, %.4f allocations per %s\n",
+				benchmark.functionName,
+				elapsedMs,
+				numAllocations,
+				numAllocations / benchmark.numOperations,
+				benchmark.operationName );
+#else
+		printf( "%s: %.3f ms per call\n", benchmark.functionName, elapsedMs );
+#endif // SCRIPT_HEAP_STATS
 	}
 }
 
@@ -4891,7 +8200,10 @@ enum EMenuSection
 	MS_ShowUserIdentifiers,
 	MS_ShowFunctions,
 	MS_CallScriptFunction,
-	MS_Exit
+	MS_Exit,
+	MS_RunBenchmarks,
+	MS_ShowMemoryStats,
+	MS_ShowByteCode
 };
 
 int main()
@@ -4908,7 +8220,10 @@ int main()
 				"3. Show user identifiers\n"
 				"4. Show all functions\n"
 				"5. Call script function\n"
-				"6. Exit\n\n> " );
+				"6. Exit\n"
+				"7. Run benchmarks\n"
+				"8. Show memory stats\n"
+				"9. Show byte code\n\n> " );
 		scanf( "%i", &indexMenu );
 
 		switch ( indexMenu )
@@ -4958,6 +8273,24 @@ int main()
 			system( "pause" );
 			break;
 		}
+
+		case MS_RunBenchmarks:
+			system( "cls" );
+			RunBenchmarks();
+			system( "pause" );
+			break;
+
+		case MS_ShowMemoryStats:
+			system( "cls" );
+			GCTranslator.DumpMemoryStats();
+			system( "pause" );
+			break;
+
+		case MS_ShowByteCode:
+			system( "cls" );
+			GCTranslator.DumpByteCode();
+			system( "pause" );
+			break;
 		}
 	}
 